@@ -0,0 +1,155 @@
+#include "dbusfixture.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/message.hpp>
+#include <sensorobjects.hpp>
+#include <string>
+
+#include "benchmark/benchmark.h"
+
+// heap allocations made by this process, for the allocs counters
+static std::atomic<size_t> allocations{0};
+
+void* operator new(size_t size)
+{
+    allocations++;
+    void* p = std::malloc(size ? size : 1);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+constexpr size_t replyObjects = 500;
+
+using ManagedObjectType =
+    std::map<sdbusplus::message::object_path,
+             std::map<std::string, std::map<std::string, ipmi::DbusVariant>>>;
+
+// a sealed GetManagedObjects style reply from a sensor service, with the
+// decorators real services add next to the sensor interfaces
+struct SensorReply
+{
+    SensorReply() : bus(sdbusplus::bus::new_system())
+    {
+        ManagedObjectType objects;
+        for (size_t ii = 0; ii < replyObjects; ii++)
+        {
+            auto& sensor = objects[sdbusplus::message::object_path(
+                "/xyz/openbmc_project/sensors/temperature/Temp_" +
+                std::to_string(ii))];
+            sensor["xyz.openbmc_project.Sensor.Value"] = {
+                {"Value", 42.0}, {"MaxValue", 127.0}, {"MinValue", -128.0}};
+            sensor["xyz.openbmc_project.Sensor.Threshold.Warning"] = {
+                {"WarningHigh", 90.0},
+                {"WarningLow", 5.0},
+                {"WarningAlarmHigh", false},
+                {"WarningAlarmLow", false}};
+            sensor["xyz.openbmc_project.Sensor.Threshold.Critical"] = {
+                {"CriticalHigh", 100.0},
+                {"CriticalLow", 0.0},
+                {"CriticalAlarmHigh", false},
+                {"CriticalAlarmLow", false}};
+            sensor["xyz.openbmc_project.State.Decorator.OperationalStatus"] =
+                {{"Functional", true}};
+            sensor["xyz.openbmc_project.State.Decorator.Availability"] = {
+                {"Available", true}};
+            sensor["xyz.openbmc_project.Inventory.Decorator.Asset"] = {
+                {"Manufacturer", std::string("Intel Corporation")},
+                {"Model", std::string("Thermal diode")}};
+        }
+        message = bus.new_signal("/", "org.freedesktop.DBus.ObjectManager",
+                                 "InterfacesAdded");
+        message.append(objects);
+        sd_bus_message_seal(message.get(), 1, 0);
+    }
+
+    sd_bus_message* rewound()
+    {
+        sd_bus_message_rewind(message.get(), 1);
+        return message.get();
+    }
+
+    ipmi::test::DbusDaemon daemon;
+    sdbusplus::bus::bus bus;
+    sdbusplus::message::message message;
+};
+
+SensorReply& sensorReply()
+{
+    static SensorReply reply;
+    return reply;
+}
+} // namespace
+
+// what getSensorMap did before: decode everything into nested std::maps
+static void BM_decodeManagedObjectsMap(benchmark::State& state)
+{
+    SensorReply& reply = sensorReply();
+    size_t before = allocations;
+    for (auto _ : state)
+    {
+        reply.rewound();
+        ManagedObjectType objects;
+        reply.message.read(objects);
+        benchmark::DoNotOptimize(objects);
+    }
+    state.counters["allocs"] = benchmark::Counter(
+        allocations - before, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_decodeManagedObjectsMap);
+
+// every interface, but into the arena
+static void BM_decodeManagedObjectsArena(benchmark::State& state)
+{
+    SensorReply& reply = sensorReply();
+    ipmi::arena::RefreshArena arena;
+    ipmi::arena::ObjectMap objects(arena.resource());
+    size_t before = allocations;
+    for (auto _ : state)
+    {
+        objects.clear();
+        arena.reset();
+        ipmi::arena::readManagedObjects(reply.rewound(), arena, objects);
+        benchmark::DoNotOptimize(objects);
+    }
+    state.counters["allocs"] = benchmark::Counter(
+        allocations - before, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_decodeManagedObjectsArena);
+
+// what getSensorMap does now: sensor interfaces only, into the arena
+static void BM_decodeSensorObjectsArena(benchmark::State& state)
+{
+    SensorReply& reply = sensorReply();
+    ipmi::arena::RefreshArena arena;
+    ipmi::arena::ObjectMap objects(arena.resource());
+    size_t before = allocations;
+    for (auto _ : state)
+    {
+        objects.clear();
+        arena.reset();
+        ipmi::readSensorObjects(reply.rewound(), arena, objects);
+        benchmark::DoNotOptimize(objects);
+    }
+    state.counters["allocs"] = benchmark::Counter(
+        allocations - before, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_decodeSensorObjectsArena);
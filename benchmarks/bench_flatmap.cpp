@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <flatmaputils.hpp>
+#include <sdrutils.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+namespace
+{
+using SubTreeEntries = std::vector<std::pair<
+    std::string,
+    boost::container::flat_map<std::string, std::vector<std::string>>>>;
+
+// a mapper GetSubTree reply for the sensors: strcmp order, which for
+// numbered sensors (Fan_10 before Fan_2) is not the tree's version order. A
+// mapper reply is already close to sorted, so emplace mostly appends; the
+// reversed reply is the worst case, every emplace moving the whole vector.
+SubTreeEntries makeMapperReply(size_t count, bool reversed)
+{
+    SubTreeEntries entries;
+    for (size_t ii = 0; ii < count; ii++)
+    {
+        entries.emplace_back(
+            "/xyz/openbmc_project/sensors/temperature/Sensor_" +
+                std::to_string(ii),
+            boost::container::flat_map<std::string, std::vector<std::string>>{
+                {"xyz.openbmc_project.HwmonTempSensor",
+                 {"xyz.openbmc_project.Sensor.Value",
+                  "xyz.openbmc_project.Sensor.Threshold.Warning",
+                  "xyz.openbmc_project.Sensor.Threshold.Critical"}}});
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    if (reversed)
+    {
+        std::reverse(entries.begin(), entries.end());
+    }
+    return entries;
+}
+} // namespace
+
+// how sdbusplus fills a flat_map: one emplace per dictionary entry
+static void BM_subTreeEmplace(benchmark::State& state)
+{
+    SubTreeEntries reply = makeMapperReply(state.range(0), state.range(1));
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        SubTreeEntries entries = reply;
+        state.ResumeTiming();
+        SensorSubTree tree;
+        for (auto& entry : entries)
+        {
+            tree.emplace(std::move(entry));
+        }
+        benchmark::DoNotOptimize(tree);
+    }
+}
+BENCHMARK(BM_subTreeEmplace)
+    ->ArgNames({"entries", "reversed"})
+    ->ArgsProduct({{250, 500, 1000, 2000, 4000, 8000}, {0, 1}});
+
+// what getSensorSubtree does now
+static void BM_subTreeAdopt(benchmark::State& state)
+{
+    SubTreeEntries reply = makeMapperReply(state.range(0), state.range(1));
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        SubTreeEntries entries = reply;
+        state.ResumeTiming();
+        SensorSubTree tree;
+        ipmi::adoptUnsorted(tree, std::move(entries));
+        benchmark::DoNotOptimize(tree);
+    }
+}
+BENCHMARK(BM_subTreeAdopt)
+    ->ArgNames({"entries", "reversed"})
+    ->ArgsProduct({{250, 500, 1000, 2000, 4000, 8000}, {0, 1}});
@@ -0,0 +1,166 @@
+#include <intern.hpp>
+#include <sdrutils.hpp>
+#include <selutils.hpp>
+#include <sensorsdr.hpp>
+#include <sensorutils.hpp>
+#include <stdexcept>
+#include <string>
+
+#include "benchmark/benchmark.h"
+
+// The requests that miss: an unknown sensor, a reading or threshold outside
+// the sensor's range and a corrupt SEL field. Each pair measures the
+// exception based version these paths used before against the current one.
+namespace
+{
+SensorNumMap makeSensorNumMap(ipmi::intern::Table& paths, size_t count)
+{
+    SensorNumMap sensorNumMap;
+    for (size_t ii = 0; ii < count; ii++)
+    {
+        sensorNumMap.insert(SensorNumMap::value_type(
+            ii + 1,
+            paths.intern("/xyz/openbmc_project/sensors/temperature/Sensor_" +
+                         std::to_string(ii))));
+    }
+    return sensorNumMap;
+}
+
+uint8_t scaleOrThrow(double value, int16_t mValue, int8_t rExp,
+                     int16_t bValue, int8_t bExp, bool bSigned)
+{
+    std::optional<uint8_t> scaled = ipmi::scaleIPMIValueFromDouble(
+        value, mValue, rExp, bValue, bExp, bSigned);
+    if (!scaled)
+    {
+        throw std::out_of_range("Value out of range");
+    }
+    return *scaled;
+}
+} // namespace
+
+static void BM_sensorNumberMissThrow(benchmark::State& state)
+{
+    ipmi::intern::Table paths;
+    SensorNumMap sensorNumMap = makeSensorNumMap(paths, 200);
+    ipmi::intern::Id unknown =
+        paths.intern("/xyz/openbmc_project/sensors/temperature/Unknown");
+    for (auto _ : state)
+    {
+        uint8_t sensorNum;
+        try
+        {
+            sensorNum = sensorNumMap.right.at(unknown);
+        }
+        catch (std::out_of_range&)
+        {
+            sensorNum = 0xFF;
+        }
+        benchmark::DoNotOptimize(sensorNum);
+    }
+}
+BENCHMARK(BM_sensorNumberMissThrow);
+
+// what getSensorNumberFromPath does now
+static void BM_sensorNumberMiss(benchmark::State& state)
+{
+    ipmi::intern::Table paths;
+    SensorNumMap sensorNumMap = makeSensorNumMap(paths, 200);
+    ipmi::intern::Id unknown =
+        paths.intern("/xyz/openbmc_project/sensors/temperature/Unknown");
+    for (auto _ : state)
+    {
+        auto sensor = sensorNumMap.right.find(unknown);
+        uint8_t sensorNum =
+            sensor == sensorNumMap.right.end() ? 0xFF : sensor->second;
+        benchmark::DoNotOptimize(sensorNum);
+    }
+}
+BENCHMARK(BM_sensorNumberMiss);
+
+static void BM_scaleOutOfRangeThrow(benchmark::State& state)
+{
+    int16_t mValue;
+    int8_t rExp;
+    int16_t bValue;
+    int8_t bExp;
+    bool bSigned;
+    ipmi::getSensorAttributes(255, 0, mValue, rExp, bValue, bExp, bSigned);
+    for (auto _ : state)
+    {
+        uint8_t scaled;
+        try
+        {
+            scaled = scaleOrThrow(300, mValue, rExp, bValue, bExp, bSigned);
+        }
+        catch (std::out_of_range&)
+        {
+            scaled = 0;
+        }
+        benchmark::DoNotOptimize(scaled);
+    }
+}
+BENCHMARK(BM_scaleOutOfRangeThrow);
+
+static void BM_scaleOutOfRange(benchmark::State& state)
+{
+    int16_t mValue;
+    int8_t rExp;
+    int16_t bValue;
+    int8_t bExp;
+    bool bSigned;
+    ipmi::getSensorAttributes(255, 0, mValue, rExp, bValue, bExp, bSigned);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(ipmi::scaleIPMIValueFromDouble(
+            300, mValue, rExp, bValue, bExp, bSigned));
+    }
+}
+BENCHMARK(BM_scaleOutOfRange);
+
+// a critical threshold above the sensor's maximum
+static void BM_getIPMIThresholdsMiss(benchmark::State& state)
+{
+    ipmi::SensorMap sensorMap;
+    sensorMap["xyz.openbmc_project.Sensor.Value"] = {
+        {"Value", 50.0}, {"MaxValue", 255.0}, {"MinValue", 0.0}};
+    sensorMap["xyz.openbmc_project.Sensor.Threshold.Critical"] = {
+        {"CriticalHigh", 300.0}, {"CriticalLow", 5.0}};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(ipmi::getIPMIThresholds(sensorMap));
+    }
+}
+BENCHMARK(BM_getIPMIThresholdsMiss);
+
+static void BM_parseJournalIntMissThrow(benchmark::State& state)
+{
+    std::string metadata = "none";
+    for (auto _ : state)
+    {
+        int contents = 0;
+        int ret = 0;
+        try
+        {
+            contents = static_cast<int>(std::stoul(metadata, nullptr, 16));
+        }
+        catch (std::invalid_argument&)
+        {
+            ret = -1;
+        }
+        benchmark::DoNotOptimize(ret + contents);
+    }
+}
+BENCHMARK(BM_parseJournalIntMissThrow);
+
+static void BM_parseJournalIntMiss(benchmark::State& state)
+{
+    std::string metadata = "none";
+    for (auto _ : state)
+    {
+        int contents = 0;
+        benchmark::DoNotOptimize(
+            intel_oem::ipmi::sel::parseJournalInt(metadata, 16, contents));
+    }
+}
+BENCHMARK(BM_parseJournalIntMiss);
@@ -0,0 +1,111 @@
+#include <array>
+#include <sensorsdr.hpp>
+#include <sensorutils.hpp>
+#include <string>
+
+#include "benchmark/benchmark.h"
+
+namespace
+{
+struct SensorRange
+{
+    double max;
+    double min;
+};
+
+// one entry per typical sensor type: raw byte, temperature, 12V rail, fan
+// tach and PSU power
+constexpr std::array<SensorRange, 5> sensorRanges = {
+    {{255, 0}, {127, -128}, {16, 0}, {25000, 0}, {3000, 0}}};
+
+void rangeArguments(benchmark::internal::Benchmark* bench)
+{
+    for (size_t ii = 0; ii < sensorRanges.size(); ii++)
+    {
+        bench->Arg(ii);
+    }
+}
+
+ipmi::SensorMap makeSensorMap(const SensorRange& range, bool thresholds)
+{
+    ipmi::SensorMap sensorMap;
+    sensorMap["xyz.openbmc_project.Sensor.Value"] = {
+        {"Value", (range.max + range.min) / 2},
+        {"MaxValue", range.max},
+        {"MinValue", range.min}};
+    if (thresholds)
+    {
+        // all thresholds in the upper half, so they are positive even for the
+        // signed ranges
+        double span = range.max - range.min;
+        sensorMap["xyz.openbmc_project.Sensor.Threshold.Warning"] = {
+            {"WarningHigh", range.min + span * 0.8},
+            {"WarningLow", range.min + span * 0.6}};
+        sensorMap["xyz.openbmc_project.Sensor.Threshold.Critical"] = {
+            {"CriticalHigh", range.min + span * 0.9},
+            {"CriticalLow", range.min + span * 0.55}};
+    }
+    return sensorMap;
+}
+} // namespace
+
+static void BM_getSensorAttributes(benchmark::State& state)
+{
+    const SensorRange& range = sensorRanges[state.range(0)];
+    int16_t mValue;
+    int8_t rExp;
+    int16_t bValue;
+    int8_t bExp;
+    bool bSigned;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(ipmi::getSensorAttributes(
+            range.max, range.min, mValue, rExp, bValue, bExp, bSigned));
+    }
+}
+BENCHMARK(BM_getSensorAttributes)->Apply(rangeArguments);
+
+static void BM_scaleIPMIValueFromDouble(benchmark::State& state)
+{
+    const SensorRange& range = sensorRanges[state.range(0)];
+    int16_t mValue;
+    int8_t rExp;
+    int16_t bValue;
+    int8_t bExp;
+    bool bSigned;
+    ipmi::getSensorAttributes(range.max, range.min, mValue, rExp, bValue, bExp,
+                              bSigned);
+    double value = (range.max + range.min) / 2;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(ipmi::scaleIPMIValueFromDouble(
+            value, mValue, rExp, bValue, bExp, bSigned));
+    }
+}
+BENCHMARK(BM_scaleIPMIValueFromDouble)->Apply(rangeArguments);
+
+static void BM_getIPMIThresholds(benchmark::State& state)
+{
+    ipmi::SensorMap sensorMap =
+        makeSensorMap(sensorRanges[state.range(0)], true);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(ipmi::getIPMIThresholds(sensorMap));
+    }
+}
+BENCHMARK(BM_getIPMIThresholds)->Apply(rangeArguments);
+
+// the full sensor record part of Get SDR, without the D-Bus lookups
+static void BM_constructSensorSdr(benchmark::State& state)
+{
+    ipmi::SensorMap sensorMap = makeSensorMap(sensorRanges[1], state.range(0));
+    std::string path = "/xyz/openbmc_project/sensors/temperature/CPU1_Temp";
+    get_sdr::SensorDataFullRecord record;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            ipmi::constructSensorSdr(1, path, sensorMap, record));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_constructSensorSdr)->Arg(0)->Arg(1);
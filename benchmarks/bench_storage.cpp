@@ -0,0 +1,98 @@
+#include <array>
+#include <fruutils.hpp>
+#include <selutils.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+namespace
+{
+// common header with chassis, board and product areas, board area last
+std::vector<uint8_t> makeFru()
+{
+    std::vector<uint8_t> fru(256, 0);
+    fru[0] = 0x01; // format version
+    fru[2] = 0x01; // chassis area at 8
+    fru[3] = 0x0A; // board area at 80
+    fru[4] = 0x05; // product area at 40
+    fru[7] = static_cast<uint8_t>(-(0x01 + 0x01 + 0x0A + 0x05));
+    fru[80] = 0x01;
+    fru[81] = 0x08; // 64 byte board area
+    return fru;
+}
+
+// the fields Get SEL Entry decodes for a system event record
+constexpr std::array<std::string_view, 6> systemEventFields = {
+    "IPMI_SEL_RECORD_ID=4711",
+    "IPMI_SEL_RECORD_TYPE=2",
+    "IPMI_SEL_GENERATOR_ID=20",
+    "IPMI_SEL_SENSOR_PATH=/xyz/openbmc_project/sensors/temperature/CPU1_Temp",
+    "IPMI_SEL_EVENT_DIR=1",
+    "IPMI_SEL_DATA=57FFFF",
+};
+} // namespace
+
+static void BM_getFruDataEnd(benchmark::State& state)
+{
+    std::vector<uint8_t> fru = makeFru();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            ipmi::storage::getFruDataEnd(fru, state.range(0)));
+    }
+}
+// length byte of the last area not yet written, and the complete image
+BENCHMARK(BM_getFruDataEnd)->Arg(64)->Arg(256);
+
+static void BM_fromHexStr(benchmark::State& state)
+{
+    std::string hexStr(state.range(0) * 2, 'A');
+    std::vector<uint8_t> data;
+    for (auto _ : state)
+    {
+        data.clear();
+        benchmark::DoNotOptimize(
+            intel_oem::ipmi::sel::fromHexStr(hexStr, data));
+    }
+    state.SetBytesProcessed(state.iterations() * hexStr.size());
+}
+// system event data, OEM timestamped data and OEM data
+BENCHMARK(BM_fromHexStr)->Arg(3)->Arg(9)->Arg(13);
+
+static void BM_decodeSystemEventFields(benchmark::State& state)
+{
+    namespace sel = intel_oem::ipmi::sel;
+    for (auto _ : state)
+    {
+        int recordId = 0;
+        int recordType = 0;
+        int generatorId = 0;
+        int eventDir = 0;
+        std::vector<uint8_t> eventData;
+
+        sel::parseJournalInt(
+            std::string(sel::getJournalFieldValue(systemEventFields[0])), 10,
+            recordId);
+        sel::parseJournalInt(
+            std::string(sel::getJournalFieldValue(systemEventFields[1])), 16,
+            recordType);
+        sel::parseJournalInt(
+            std::string(sel::getJournalFieldValue(systemEventFields[2])), 16,
+            generatorId);
+        std::string path(sel::getJournalFieldValue(systemEventFields[3]));
+        sel::parseJournalInt(
+            std::string(sel::getJournalFieldValue(systemEventFields[4])), 16,
+            eventDir);
+        sel::fromHexStr(
+            std::string(sel::getJournalFieldValue(systemEventFields[5])),
+            eventData);
+
+        benchmark::DoNotOptimize(recordId + recordType + generatorId +
+                                 eventDir);
+        benchmark::DoNotOptimize(path.data());
+        benchmark::DoNotOptimize(eventData.data());
+    }
+}
+BENCHMARK(BM_decodeSystemEventFields);
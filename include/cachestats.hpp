@@ -0,0 +1,63 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Effectiveness counters for the provider caches, kept in the common library
+// so that caches used from several providers report a single set of numbers.
+// The generation changes every time the cached contents are replaced or
+// dropped, so two reads with the same generation saw the same data.
+namespace ipmi
+{
+namespace cache
+{
+enum class CacheId : uint8_t
+{
+    sensors = 0,
+    sdr = 1,
+    fru = 2,
+    sel = 3,
+    settings = 4,
+};
+static constexpr const size_t cacheCount = 5;
+
+struct CacheCounters
+{
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t refreshes = 0;
+    uint32_t invalidations = 0;
+    uint32_t generation = 0;
+};
+
+void hit(CacheId id);
+
+void miss(CacheId id);
+
+// the cache was reloaded from its backing service
+void refresh(CacheId id);
+
+// the cached contents were dropped and must be reloaded
+void invalidate(CacheId id);
+
+CacheCounters getCounters(CacheId id);
+
+// clears hit/miss/refresh/invalidation counts, generations are kept
+void resetCounters();
+} // namespace cache
+} // namespace ipmi
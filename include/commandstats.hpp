@@ -0,0 +1,118 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ipmi
+{
+namespace stats
+{
+static constexpr const char* statsPath = "/xyz/openbmc_project/ipmi/stats";
+static constexpr const char* statsIntf = "xyz.openbmc_project.Ipmi.Stats";
+static constexpr const char* statsDumpFile = "/run/ipmi_command_stats";
+
+// bucket 0 holds latencies below 1us, bucket n holds [2^(n-1), 2^n) us and
+// the last bucket also collects everything above
+static constexpr const size_t histogramBuckets = 32;
+
+inline size_t histogramBucket(uint64_t us)
+{
+    if (us == 0)
+    {
+        return 0;
+    }
+    size_t bucket = 64 - __builtin_clzll(us);
+    if (bucket >= histogramBuckets)
+    {
+        bucket = histogramBuckets - 1;
+    }
+    return bucket;
+}
+
+// upper bound in microseconds of the values counted in a bucket
+inline uint64_t histogramBucketLimit(size_t bucket)
+{
+    return uint64_t(1) << bucket;
+}
+
+struct CommandHistogram
+{
+    uint64_t count = 0;
+    uint64_t errors = 0;
+    uint64_t totalUs = 0;
+    uint64_t maxUs = 0;
+    std::array<uint64_t, histogramBuckets> buckets = {};
+
+    void record(uint64_t us, uint8_t cc)
+    {
+        count++;
+        if (cc != 0)
+        {
+            errors++;
+        }
+        totalUs += us;
+        if (us > maxUs)
+        {
+            maxUs = us;
+        }
+        buckets[histogramBucket(us)]++;
+    }
+
+    // returns the bucket upper bound that the given percentile falls in,
+    // which is as precise as a log bucketed histogram gets
+    uint64_t percentile(unsigned int pct) const
+    {
+        if (count == 0)
+        {
+            return 0;
+        }
+        uint64_t target = (count * pct + 99) / 100;
+        uint64_t seen = 0;
+        for (size_t bucket = 0; bucket < histogramBuckets; bucket++)
+        {
+            seen += buckets[bucket];
+            if (seen >= target)
+            {
+                return histogramBucketLimit(bucket);
+            }
+        }
+        return histogramBucketLimit(histogramBuckets - 1);
+    }
+};
+
+inline uint64_t
+    elapsedUs(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// histograms are kept in the common library so every provider reports into
+// the same D-Bus object, the returned reference stays valid for the life of
+// the process
+CommandHistogram& getCommandHistogram(uint8_t netfn, uint8_t cmd);
+
+void resetCommandHistograms();
+
+bool dumpCommandHistograms(const std::string& path);
+} // namespace stats
+} // namespace ipmi
@@ -15,9 +15,24 @@
 */
 
 #pragma once
+#include <algorithm>
+#include <array>
+#include <boost/container/flat_map.hpp>
+#include <chrono>
+#include <commandstats.hpp>
+#include <dbusaccounting.hpp>
+#include <flightrecorder.hpp>
 #include <iostream>
 #include <ipmid/api.hpp>
+#include <limits>
+#include <optional>
 #include <sdbusplus/bus.hpp>
+#include <tracepoints.hpp>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
 
 static constexpr bool debug = false;
 
@@ -30,13 +45,199 @@ inline static void printRegistration(unsigned int netfn, unsigned int cmd)
     }
 }
 
+namespace details
+{
+template <typename T>
+inline size_t packedSize(const T& value);
+template <typename T, size_t N>
+inline size_t packedSize(const std::array<T, N>& values);
+template <typename T>
+inline size_t packedSize(const std::vector<T>& values);
+template <typename T>
+inline size_t packedSize(const std::optional<T>& value);
+template <typename... T>
+inline size_t packedSize(const std::variant<T...>& value);
+template <typename... T>
+inline size_t packedSize(const std::tuple<T...>& values);
+
+// wire size of a typed handler argument or response, used for the flight
+// recorder request/response lengths
+template <typename T>
+inline size_t packedSize(const T& value)
+{
+    if constexpr (std::is_integral_v<T> || std::is_enum_v<T>)
+    {
+        return sizeof(T);
+    }
+    else if constexpr (std::is_same_v<T, ipmi::message::Payload>)
+    {
+        return value.size();
+    }
+    // contexts and anything else not carried in the message
+    return 0;
+}
+
+template <typename T, size_t N>
+inline size_t packedSize(const std::array<T, N>& values)
+{
+    size_t size = 0;
+    for (const T& value : values)
+    {
+        size += packedSize(value);
+    }
+    return size;
+}
+
+template <typename T>
+inline size_t packedSize(const std::vector<T>& values)
+{
+    size_t size = 0;
+    for (const T& value : values)
+    {
+        size += packedSize(value);
+    }
+    return size;
+}
+
+template <typename T>
+inline size_t packedSize(const std::optional<T>& value)
+{
+    return value ? packedSize(*value) : 0;
+}
+
+template <typename... T>
+inline size_t packedSize(const std::variant<T...>& value)
+{
+    return std::visit([](const auto& v) { return packedSize(v); }, value);
+}
+
+template <typename... T>
+inline size_t packedSize(const std::tuple<T...>& values)
+{
+    return std::apply(
+        [](const auto&... v) { return (packedSize(v) + ... + size_t(0)); },
+        values);
+}
+
+template <typename... Args>
+struct FirstIsContext : std::false_type
+{
+};
+
+template <typename First, typename... Rest>
+struct FirstIsContext<First, Rest...>
+    : std::is_same<std::decay_t<First>, ipmi::Context::ptr>
+{
+};
+
+// bookkeeping shared by the timed handler wrappers: USDT probes, latency
+// histogram, D-Bus accounting and the flight recorder. A handler that throws
+// never reaches finish, so the destructor records it with cc 0xFF.
+class RequestTrace
+{
+  public:
+    RequestTrace(ipmi::stats::CommandHistogram& histogram, uint8_t netfn,
+                 uint8_t cmd, uint8_t channel, size_t requestLength) :
+        histogram(histogram),
+        netfn(netfn), cmd(cmd), channel(channel), requestLength(requestLength),
+        timestamp(std::chrono::system_clock::now()),
+        start(std::chrono::steady_clock::now())
+    {
+        IPMI_PROBE2(handler_entry, netfn, cmd);
+        ipmi::accounting::beginRequest(netfn, cmd);
+    }
+
+    RequestTrace(const RequestTrace&) = delete;
+    RequestTrace& operator=(const RequestTrace&) = delete;
+
+    ~RequestTrace()
+    {
+        if (!finished)
+        {
+            finish(IPMI_CC_UNSPECIFIED_ERROR, 0);
+        }
+    }
+
+    void finish(uint8_t cc, size_t responseLength)
+    {
+        finished = true;
+        uint64_t elapsed = ipmi::stats::elapsedUs(start);
+        IPMI_PROBE4(handler_exit, netfn, cmd, cc, elapsed);
+        histogram.record(elapsed, cc);
+
+        ipmi::flight::Entry entry;
+        entry.timestampUs =
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                timestamp.time_since_epoch())
+                .count();
+        entry.latencyUs = static_cast<uint32_t>(
+            std::min<uint64_t>(elapsed, std::numeric_limits<uint32_t>::max()));
+        entry.requestLength = static_cast<uint16_t>(requestLength);
+        entry.responseLength = static_cast<uint16_t>(responseLength);
+        entry.dbusCalls = static_cast<uint16_t>(std::min<uint32_t>(
+            ipmi::accounting::requestDbusCalls(),
+            std::numeric_limits<uint16_t>::max()));
+        entry.channel = channel;
+        entry.netfn = netfn;
+        entry.cmd = cmd;
+        entry.cc = cc;
+        ipmi::flight::record(entry);
+
+        ipmi::accounting::endRequest(elapsed);
+    }
+
+  private:
+    ipmi::stats::CommandHistogram& histogram;
+    bool finished = false;
+    uint8_t netfn;
+    uint8_t cmd;
+    uint8_t channel;
+    size_t requestLength;
+    std::chrono::system_clock::time_point timestamp;
+    std::chrono::steady_clock::time_point start;
+};
+
+// legacy callbacks are plain function pointers, so the real handler is looked
+// up by netfn/cmd from a single timing trampoline
+static boost::container::flat_map<uint16_t, ipmid_callback_t> legacyHandlers;
+
+static ipmi_ret_t timedLegacyHandler(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
+                                     ipmi_request_t request,
+                                     ipmi_response_t response,
+                                     ipmi_data_len_t dataLen,
+                                     ipmi_context_t context)
+{
+    auto handler = legacyHandlers.find(static_cast<uint16_t>(netfn << 8 | cmd));
+    if (handler == legacyHandlers.end())
+    {
+        handler = legacyHandlers.find(
+            static_cast<uint16_t>(netfn << 8 | IPMI_CMD_WILDCARD));
+        if (handler == legacyHandlers.end())
+        {
+            *dataLen = 0;
+            return IPMI_CC_INVALID;
+        }
+    }
+
+    // the legacy interface does not say which channel the request came from
+    RequestTrace trace(ipmi::stats::getCommandHistogram(netfn, cmd), netfn,
+                       cmd, ipmi::flight::unknownChannel, *dataLen);
+    ipmi_ret_t cc =
+        handler->second(netfn, cmd, request, response, dataLen, context);
+    trace.finish(cc, *dataLen);
+    return cc;
+}
+} // namespace details
+
 inline static void ipmiPrintAndRegister(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                                         ipmi_context_t context,
                                         ipmid_callback_t handler,
                                         ipmi_cmd_privilege_t priv)
 {
     printRegistration(netfn, cmd);
-    ipmi_register_callback(netfn, cmd, context, handler, priv);
+    details::legacyHandlers[static_cast<uint16_t>(netfn << 8 | cmd)] = handler;
+    ipmi_register_callback(netfn, cmd, context, details::timedLegacyHandler,
+                           priv);
 }
 
 inline static void printCommand(unsigned int netfn, unsigned int cmd)
@@ -50,6 +251,47 @@ inline static void printCommand(unsigned int netfn, unsigned int cmd)
 
 namespace ipmi
 {
+// same as ipmi::registerHandler, but records the handler latency in the
+// command histograms and flight recorder and accounts the D-Bus calls it makes
+template <typename Ret, typename... Args>
+inline static bool registerTimedHandler(int prio, NetFn netfn, Cmd cmd,
+                                        Privilege priv,
+                                        Ret (*handler)(Args...))
+{
+    printRegistration(netfn, cmd);
+    stats::CommandHistogram* histogram =
+        &stats::getCommandHistogram(netfn, cmd);
+    auto timedCall = [netfn, cmd, histogram,
+                      handler](const Context::ptr& ctx, Args&... args) -> Ret {
+        ::details::RequestTrace trace(
+            *histogram, netfn, cmd, static_cast<uint8_t>(ctx->channel),
+            (::details::packedSize(args) + ... + size_t(0)));
+        Ret response = handler(std::forward<Args>(args)...);
+        trace.finish(std::get<0>(response),
+                     ::details::packedSize(std::get<1>(response)));
+        return response;
+    };
+
+    // ipmid only hands the context to handlers that ask for it first
+    if constexpr (::details::FirstIsContext<Args...>::value)
+    {
+        return registerHandler(prio, netfn, cmd, priv,
+                               [timedCall](Args... args) -> Ret {
+                                   return timedCall(
+                                       std::get<0>(std::tie(args...)),
+                                       args...);
+                               });
+    }
+    else
+    {
+        return registerHandler(
+            prio, netfn, cmd, priv,
+            [timedCall](Context::ptr ctx, Args... args) -> Ret {
+                return timedCall(ctx, args...);
+            });
+    }
+}
+
 using DbusVariant =
     sdbusplus::message::variant<std::string, bool, uint8_t, uint16_t, int16_t,
                                 uint32_t, int32_t, uint64_t, int64_t, double>;
@@ -0,0 +1,146 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <chrono>
+#include <commandstats.hpp>
+#include <cstdint>
+#include <ipmid/utils.hpp>
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/message.hpp>
+#include <string>
+#include <string_view>
+#include <systemd/sd-bus.h>
+#include <tracepoints.hpp>
+#include <utility>
+
+// Attributes the D-Bus calls made while an IPMI request is being handled to
+// that request. The timed handler wrappers in commandutils.hpp open and close
+// the request, calls made outside of a request (matches, timers) are ignored.
+namespace ipmi
+{
+namespace accounting
+{
+static constexpr const char* mapperService = "xyz.openbmc_project.ObjectMapper";
+
+// requests slower than this log a summary of their D-Bus calls, settable at
+// runtime through the SlowRequestThresholdUs property of the stats object
+static constexpr const uint64_t defaultSlowRequestThresholdUs = 100000;
+
+void beginRequest(uint8_t netfn, uint8_t cmd);
+
+// must follow every beginRequest, including when the handler throws, or
+// calls from matches and timers are charged to the request; RequestTrace
+// calls it from its destructor, so it doesn't throw
+void endRequest(uint64_t elapsedUs) noexcept;
+
+void recordDbusCall(std::string_view service, uint64_t elapsedUs);
+
+// number of D-Bus calls made so far by the current request
+uint32_t requestDbusCalls();
+
+uint64_t getSlowRequestThreshold();
+
+void setSlowRequestThreshold(uint64_t thresholdUs);
+
+class ScopedDbusCall
+{
+  public:
+    explicit ScopedDbusCall(const char* service) :
+        service(service), start(std::chrono::steady_clock::now())
+    {
+        IPMI_PROBE1(dbus_call_start, service);
+    }
+
+    explicit ScopedDbusCall(const std::string& service) :
+        ScopedDbusCall(service.c_str())
+    {
+    }
+
+    ~ScopedDbusCall()
+    {
+        uint64_t elapsed = stats::elapsedUs(start);
+        IPMI_PROBE2(dbus_call_end, service, elapsed);
+        recordDbusCall(service, elapsed);
+    }
+
+    ScopedDbusCall(const ScopedDbusCall&) = delete;
+    ScopedDbusCall& operator=(const ScopedDbusCall&) = delete;
+
+  private:
+    const char* service;
+    std::chrono::steady_clock::time_point start;
+};
+
+inline sdbusplus::message::message call(sdbusplus::bus::bus& bus,
+                                        sdbusplus::message::message& m)
+{
+    const char* destination = sd_bus_message_get_destination(m.get());
+    ScopedDbusCall scope(destination ? destination : "");
+    return bus.call(m);
+}
+
+// accounted versions of the ipmid D-Bus helpers
+inline std::string getService(sdbusplus::bus::bus& bus,
+                              const std::string& intf,
+                              const std::string& path)
+{
+    ScopedDbusCall scope(mapperService);
+    return ipmi::getService(bus, intf, path);
+}
+
+template <typename... Args>
+inline Value getDbusProperty(sdbusplus::bus::bus& bus,
+                             const std::string& service, Args&&... args)
+{
+    ScopedDbusCall scope(service);
+    return ipmi::getDbusProperty(bus, service, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+inline void setDbusProperty(sdbusplus::bus::bus& bus,
+                            const std::string& service, Args&&... args)
+{
+    ScopedDbusCall scope(service);
+    ipmi::setDbusProperty(bus, service, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+inline PropertyMap getAllDbusProperties(sdbusplus::bus::bus& bus,
+                                        const std::string& service,
+                                        Args&&... args)
+{
+    ScopedDbusCall scope(service);
+    return ipmi::getAllDbusProperties(bus, service,
+                                      std::forward<Args>(args)...);
+}
+
+inline ObjectValueTree getManagedObjects(sdbusplus::bus::bus& bus,
+                                         const std::string& service,
+                                         const std::string& path)
+{
+    ScopedDbusCall scope(service);
+    return ipmi::getManagedObjects(bus, service, path);
+}
+
+template <typename... Args>
+inline DbusObjectInfo getDbusObject(sdbusplus::bus::bus& bus, Args&&... args)
+{
+    ScopedDbusCall scope(mapperService);
+    return ipmi::getDbusObject(bus, std::forward<Args>(args)...);
+}
+} // namespace accounting
+} // namespace ipmi
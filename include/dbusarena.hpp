@@ -0,0 +1,362 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <systemd/sd-bus.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <intern.hpp>
+#include <map>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+// Decoding of GetManagedObjects replies that are rebuilt wholesale on every
+// refresh. Map nodes and strings all come from one monotonic arena that is
+// dropped in one go before the next refresh, instead of thousands of small
+// heap allocations being made and freed each time. Interface and property
+// names repeat on every object and are interned instead.
+namespace ipmi::arena
+{
+// Counts what the arena had to take from the heap, so the next refresh can
+// be served from the initial buffer alone.
+class UpstreamResource : public std::pmr::memory_resource
+{
+  public:
+    size_t allocated = 0;
+
+  private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        allocated += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const
+        noexcept override
+    {
+        return this == &other;
+    }
+};
+
+class RefreshArena
+{
+  public:
+    static constexpr size_t defaultSize = 16 * 1024;
+
+    explicit RefreshArena(size_t initialSize = defaultSize) :
+        buffer(initialSize)
+    {
+        pool.emplace(buffer.data(), buffer.size(), &upstream);
+    }
+
+    RefreshArena(const RefreshArena&) = delete;
+    RefreshArena& operator=(const RefreshArena&) = delete;
+
+    std::pmr::memory_resource* resource()
+    {
+        return &*pool;
+    }
+
+    // Nothing allocated from the arena may be in use any more. The buffer
+    // grows to the largest refresh seen, so steady state refreshes never
+    // touch the heap.
+    void reset()
+    {
+        pool->release();
+        if (upstream.allocated == 0)
+        {
+            return;
+        }
+        pool.reset();
+        buffer.resize(buffer.size() + upstream.allocated);
+        upstream.allocated = 0;
+        pool.emplace(buffer.data(), buffer.size(), &upstream);
+    }
+
+    size_t capacity() const
+    {
+        return buffer.size();
+    }
+
+    std::string_view copy(const char* str)
+    {
+        size_t length = std::strlen(str);
+        char* data = static_cast<char*>(pool->allocate(length + 1, 1));
+        std::memcpy(data, str, length + 1);
+        return std::string_view(data, length);
+    }
+
+  private:
+    std::vector<std::byte> buffer;
+    UpstreamResource upstream;
+    // reconstructed in place on growth, so resource() stays valid
+    std::optional<std::pmr::monotonic_buffer_resource> pool;
+};
+
+// same alternatives as DbusVariant, strings point into the arena, names
+// used as keys into the intern table
+using Value = std::variant<std::string_view, bool, uint8_t, uint16_t, int16_t,
+                           uint32_t, int32_t, uint64_t, int64_t, double>;
+using PropertyMap = std::pmr::map<std::string_view, Value>;
+using InterfaceMap = std::pmr::map<std::string_view, PropertyMap>;
+using ObjectMap = std::pmr::map<std::string_view, InterfaceMap>;
+
+// selects the interfaces worth decoding, nullptr keeps all of them
+using InterfaceFilter = bool (*)(const char* interface);
+
+namespace details
+{
+template <typename T>
+int readBasic(sd_bus_message* m, char type, Value& value)
+{
+    T data{};
+    int r = sd_bus_message_read_basic(m, type, &data);
+    if (r > 0)
+    {
+        value = data;
+    }
+    return r;
+}
+
+// reads a variant holding one of the Value types, anything else (arrays,
+// structs) is skipped and 0 returned
+inline int readVariant(sd_bus_message* m, RefreshArena& arena, Value& value)
+{
+    char type = 0;
+    const char* contents = nullptr;
+    int r = sd_bus_message_peek_type(m, &type, &contents);
+    if (r <= 0)
+    {
+        return r < 0 ? r : -EBADMSG;
+    }
+    if (contents == nullptr || std::strlen(contents) != 1)
+    {
+        r = sd_bus_message_skip(m, "v");
+        return r < 0 ? r : 0;
+    }
+
+    r = sd_bus_message_enter_container(m, SD_BUS_TYPE_VARIANT, contents);
+    if (r <= 0)
+    {
+        return r < 0 ? r : -EBADMSG;
+    }
+    switch (contents[0])
+    {
+        case SD_BUS_TYPE_STRING:
+        case SD_BUS_TYPE_OBJECT_PATH:
+        {
+            const char* data = nullptr;
+            r = sd_bus_message_read_basic(m, contents[0], &data);
+            if (r > 0)
+            {
+                value = arena.copy(data);
+            }
+            break;
+        }
+        case SD_BUS_TYPE_BOOLEAN:
+        {
+            int data = 0;
+            r = sd_bus_message_read_basic(m, contents[0], &data);
+            if (r > 0)
+            {
+                value = data != 0;
+            }
+            break;
+        }
+        case SD_BUS_TYPE_BYTE:
+            r = readBasic<uint8_t>(m, contents[0], value);
+            break;
+        case SD_BUS_TYPE_UINT16:
+            r = readBasic<uint16_t>(m, contents[0], value);
+            break;
+        case SD_BUS_TYPE_INT16:
+            r = readBasic<int16_t>(m, contents[0], value);
+            break;
+        case SD_BUS_TYPE_UINT32:
+            r = readBasic<uint32_t>(m, contents[0], value);
+            break;
+        case SD_BUS_TYPE_INT32:
+            r = readBasic<int32_t>(m, contents[0], value);
+            break;
+        case SD_BUS_TYPE_UINT64:
+            r = readBasic<uint64_t>(m, contents[0], value);
+            break;
+        case SD_BUS_TYPE_INT64:
+            r = readBasic<int64_t>(m, contents[0], value);
+            break;
+        case SD_BUS_TYPE_DOUBLE:
+            r = readBasic<double>(m, contents[0], value);
+            break;
+        default:
+            r = sd_bus_message_skip(m, contents);
+            if (r >= 0)
+            {
+                r = 0;
+            }
+            break;
+    }
+    if (r < 0)
+    {
+        return r;
+    }
+    int exit = sd_bus_message_exit_container(m);
+    return exit < 0 ? exit : r;
+}
+
+// a{sv}
+inline int readProperties(sd_bus_message* m, RefreshArena& arena,
+                          PropertyMap& properties)
+{
+    int r = sd_bus_message_enter_container(m, SD_BUS_TYPE_ARRAY, "{sv}");
+    if (r < 0)
+    {
+        return r;
+    }
+    while ((r = sd_bus_message_enter_container(m, SD_BUS_TYPE_DICT_ENTRY,
+                                               "sv")) > 0)
+    {
+        const char* name = nullptr;
+        r = sd_bus_message_read_basic(m, SD_BUS_TYPE_STRING, &name);
+        if (r < 0)
+        {
+            return r;
+        }
+        Value value;
+        r = readVariant(m, arena, value);
+        if (r < 0)
+        {
+            return r;
+        }
+        if (r > 0)
+        {
+            properties.emplace(intern::names().view(name), value);
+        }
+        r = sd_bus_message_exit_container(m);
+        if (r < 0)
+        {
+            return r;
+        }
+    }
+    if (r < 0)
+    {
+        return r;
+    }
+    return sd_bus_message_exit_container(m);
+}
+
+// a{sa{sv}}, interfaces rejected by the filter are skipped undecoded
+inline int readInterfaces(sd_bus_message* m, RefreshArena& arena,
+                          InterfaceFilter filter, InterfaceMap& interfaces)
+{
+    int r = sd_bus_message_enter_container(m, SD_BUS_TYPE_ARRAY, "{sa{sv}}");
+    if (r < 0)
+    {
+        return r;
+    }
+    while ((r = sd_bus_message_enter_container(m, SD_BUS_TYPE_DICT_ENTRY,
+                                               "sa{sv}")) > 0)
+    {
+        const char* interface = nullptr;
+        r = sd_bus_message_read_basic(m, SD_BUS_TYPE_STRING, &interface);
+        if (r < 0)
+        {
+            return r;
+        }
+        if (filter == nullptr || filter(interface))
+        {
+            r = readProperties(m, arena,
+                               interfaces[intern::names().view(interface)]);
+        }
+        else
+        {
+            r = sd_bus_message_skip(m, "a{sv}");
+        }
+        if (r < 0)
+        {
+            return r;
+        }
+        r = sd_bus_message_exit_container(m);
+        if (r < 0)
+        {
+            return r;
+        }
+    }
+    if (r < 0)
+    {
+        return r;
+    }
+    return sd_bus_message_exit_container(m);
+}
+} // namespace details
+
+// Decodes a GetManagedObjects reply (a{oa{sa{sv}}}) straight off the message
+// into objects, which must use the arena's resource. Objects left without
+// any interface after filtering are dropped. Returns a negative errno on a
+// malformed reply.
+inline int readManagedObjects(sd_bus_message* m, RefreshArena& arena,
+                              ObjectMap& objects,
+                              InterfaceFilter filter = nullptr)
+{
+    int r =
+        sd_bus_message_enter_container(m, SD_BUS_TYPE_ARRAY, "{oa{sa{sv}}}");
+    if (r < 0)
+    {
+        return r;
+    }
+    while ((r = sd_bus_message_enter_container(m, SD_BUS_TYPE_DICT_ENTRY,
+                                               "oa{sa{sv}}")) > 0)
+    {
+        const char* path = nullptr;
+        r = sd_bus_message_read_basic(m, SD_BUS_TYPE_OBJECT_PATH, &path);
+        if (r < 0)
+        {
+            return r;
+        }
+        // object managers reply in path order, so this is an append
+        auto object = objects.try_emplace(objects.end(), arena.copy(path));
+        r = details::readInterfaces(m, arena, filter, object->second);
+        if (r < 0)
+        {
+            return r;
+        }
+        if (object->second.empty())
+        {
+            objects.erase(object);
+        }
+        r = sd_bus_message_exit_container(m);
+        if (r < 0)
+        {
+            return r;
+        }
+    }
+    if (r < 0)
+    {
+        return r;
+    }
+    return sd_bus_message_exit_container(m);
+}
+} // namespace ipmi::arena
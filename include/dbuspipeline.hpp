@@ -0,0 +1,148 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <cerrno>
+#include <chrono>
+#include <commandstats.hpp>
+#include <cstdint>
+#include <dbusaccounting.hpp>
+#include <ipmid/types.hpp>
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/message.hpp>
+#include <string>
+#include <systemd/sd-bus.h>
+#include <vector>
+
+// Pipelined D-Bus property writes. Setting properties one blocking call at
+// a time pays a full round trip per write; here up to a window of Set calls
+// are in flight at once and the replies are collected as they arrive.
+//
+// The bus must be a private connection that nothing else processes, the
+// wait loop dispatches everything that arrives on it.
+namespace ipmi
+{
+namespace pipeline
+{
+static constexpr const size_t defaultWindow = 16;
+static constexpr const uint64_t callTimeoutUs = 5000000;
+
+struct PropertyWrite
+{
+    std::string service;
+    std::string path;
+    std::string interface;
+    std::string property;
+    Value value;
+};
+
+namespace details
+{
+struct PendingWrite
+{
+    sd_bus_slot* slot = nullptr;
+    const char* service = nullptr;
+    std::chrono::steady_clock::time_point start;
+    int* result = nullptr;
+    size_t* inFlight = nullptr;
+};
+
+inline int onSetReply(sd_bus_message* reply, void* userdata, sd_bus_error*)
+{
+    auto pending = static_cast<PendingWrite*>(userdata);
+    *pending->result = 0;
+    const sd_bus_error* error = sd_bus_message_get_error(reply);
+    if (error != nullptr && sd_bus_error_is_set(error))
+    {
+        int err = sd_bus_error_get_errno(error);
+        *pending->result = err > 0 ? -err : -EIO;
+    }
+    accounting::recordDbusCall(pending->service,
+                               stats::elapsedUs(pending->start));
+    (*pending->inFlight)--;
+    return 0;
+}
+} // namespace details
+
+// returns 0 or a negative errno for each write, in order
+inline std::vector<int> setProperties(sdbusplus::bus::bus& bus,
+                                      const std::vector<PropertyWrite>& writes,
+                                      size_t window = defaultWindow)
+{
+    std::vector<int> results(writes.size(), -ECANCELED);
+    std::vector<details::PendingWrite> pending(writes.size());
+    size_t inFlight = 0;
+    size_t next = 0;
+
+    while (next < writes.size() || inFlight)
+    {
+        for (; next < writes.size() && inFlight < window; next++)
+        {
+            const PropertyWrite& write = writes[next];
+            details::PendingWrite& call = pending[next];
+            call.service = write.service.c_str();
+            call.result = &results[next];
+            call.inFlight = &inFlight;
+            try
+            {
+                auto m = bus.new_method_call(
+                    write.service.c_str(), write.path.c_str(),
+                    "org.freedesktop.DBus.Properties", "Set");
+                m.append(write.interface, write.property, write.value);
+                call.start = std::chrono::steady_clock::now();
+                int r = sd_bus_call_async(bus.get(), &call.slot, m.get(),
+                                          details::onSetReply, &call,
+                                          callTimeoutUs);
+                if (r < 0)
+                {
+                    results[next] = r;
+                    continue;
+                }
+            }
+            catch (sdbusplus::exception_t&)
+            {
+                results[next] = -EINVAL;
+                continue;
+            }
+            inFlight++;
+        }
+        if (!inFlight)
+        {
+            break;
+        }
+
+        int r = sd_bus_process(bus.get(), nullptr);
+        if (r == 0)
+        {
+            // timed out calls get an error reply, so this always returns
+            r = sd_bus_wait(bus.get(), UINT64_MAX);
+        }
+        if (r < 0)
+        {
+            // connection lost, whatever is still in flight stays cancelled
+            break;
+        }
+    }
+
+    // drops the callbacks of calls abandoned above
+    for (details::PendingWrite& call : pending)
+    {
+        sd_bus_slot_unref(call.slot);
+    }
+    return results;
+}
+} // namespace pipeline
+} // namespace ipmi
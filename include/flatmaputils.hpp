@@ -0,0 +1,61 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <algorithm>
+#include <boost/container/flat_map.hpp>
+#include <iterator>
+#include <sdbusplus/message.hpp>
+#include <utility>
+#include <vector>
+
+// Bulk loading of flat_maps. Inserting element by element into the sorted
+// vector behind a flat_map moves the tail on every insert, quadratic for
+// replies that don't arrive in the map's order (mapper replies are in
+// strcmp order, the sensor tree sorts by version). Instead the entries are
+// collected, sorted once and the storage adopted.
+namespace ipmi
+{
+// entries may come in any order, on duplicate keys the first one is kept
+// like emplace() would
+template <typename FlatMap, typename Entries>
+void adoptUnsorted(FlatMap& map, Entries&& entries)
+{
+    typename FlatMap::sequence_type sequence(
+        std::make_move_iterator(entries.begin()),
+        std::make_move_iterator(entries.end()));
+    auto compare = map.value_comp();
+    std::stable_sort(sequence.begin(), sequence.end(), compare);
+    sequence.erase(std::unique(sequence.begin(), sequence.end(),
+                               [&compare](const auto& a, const auto& b) {
+                                   return !compare(a, b) && !compare(b, a);
+                               }),
+                   sequence.end());
+    map.adopt_sequence(boost::container::ordered_unique_range,
+                       std::move(sequence));
+}
+
+// reads a D-Bus dictionary (a{..}) into map, replacing its contents
+template <typename FlatMap>
+void readFlatMap(sdbusplus::message::message& m, FlatMap& map)
+{
+    std::vector<
+        std::pair<typename FlatMap::key_type, typename FlatMap::mapped_type>>
+        entries;
+    m.read(entries);
+    adoptUnsorted(map, std::move(entries));
+}
+} // namespace ipmi
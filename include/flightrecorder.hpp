@@ -0,0 +1,115 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ipmi
+{
+namespace flight
+{
+static constexpr const char* flightRecorderDumpFile =
+    "/run/ipmi_flight_recorder";
+static constexpr const size_t flightRecorderEntries = 256;
+static constexpr const uint8_t unknownChannel = 0xFF;
+
+struct Entry
+{
+    uint64_t timestampUs; // CLOCK_REALTIME
+    uint32_t latencyUs;
+    uint16_t requestLength;
+    uint16_t responseLength;
+    uint16_t dbusCalls;
+    uint8_t channel;
+    uint8_t netfn;
+    uint8_t cmd;
+    uint8_t cc;
+};
+
+// Fixed size ring of the most recent entries. Writers never block or
+// allocate; each slot carries a sequence number so a reader can drop a slot
+// that was overwritten while it was being copied.
+template <typename T, size_t N>
+class Ring
+{
+    static_assert((N & (N - 1)) == 0, "ring size must be a power of two");
+
+  public:
+    void push(const T& value)
+    {
+        uint64_t index = head.load(std::memory_order_relaxed);
+        Slot& slot = slots[index & (N - 1)];
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.value = value;
+        slot.sequence.store(index + 1, std::memory_order_release);
+        head.store(index + 1, std::memory_order_release);
+    }
+
+    // oldest first
+    std::vector<T> snapshot() const
+    {
+        std::vector<T> values;
+        uint64_t end = head.load(std::memory_order_acquire);
+        uint64_t begin = end > N ? end - N : 0;
+        values.reserve(end - begin);
+        for (uint64_t index = begin; index < end; index++)
+        {
+            const Slot& slot = slots[index & (N - 1)];
+            uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            T value = slot.value;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence == index + 1 &&
+                slot.sequence.load(std::memory_order_relaxed) == sequence)
+            {
+                values.push_back(value);
+            }
+        }
+        return values;
+    }
+
+    // total number of values ever pushed
+    uint64_t count() const
+    {
+        return head.load(std::memory_order_acquire);
+    }
+
+  private:
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence{0};
+        T value{};
+    };
+
+    std::atomic<uint64_t> head{0};
+    std::array<Slot, N> slots;
+};
+
+void record(const Entry& entry);
+
+std::vector<Entry> snapshot();
+
+bool dump(const std::string& path);
+
+// SIGUSR2 writes the recorder to flightRecorderDumpFile
+void registerDumpSignal();
+} // namespace flight
+} // namespace ipmi
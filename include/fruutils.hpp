@@ -0,0 +1,162 @@
+/*
+// Copyright (c) 2017 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <ipmid/api.hpp>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <phosphor-ipmi-host/sensorhandler.hpp>
+#include <sdbusplus/timer.hpp>
+#include <storagecommands.hpp>
+#include <utility>
+#include <vector>
+
+// The FRU cache is shared by the storage commands (FRU read/write) and the
+// sensor commands (FRU device locator records in the SDR), so it lives in the
+// common library rather than in either provider.
+namespace ipmi
+{
+namespace storage
+{
+extern std::vector<uint8_t> fruCache;
+extern std::unique_ptr<phosphor::Timer> cacheTimer;
+
+bool writeFru();
+
+// writes a whole image to the FRU at bus/address in one WriteFru call,
+// keeping the cache in step if it holds that device
+ipmi_ret_t writeFruImage(uint8_t bus, uint8_t address,
+                         const std::vector<uint8_t>& image);
+
+// bus and address of the device the last replaceCacheFru loaded; device ids
+// are reassigned on every load, these are not
+std::pair<uint8_t, uint8_t> getCacheFruAddress();
+
+void createTimer();
+
+ipmi_ret_t replaceCacheFru(uint8_t devId);
+
+ipmi_ret_t getFruSdrs(size_t index, get_sdr::SensorDataFruRecord& resp);
+
+ipmi_ret_t getFruSdrCount(size_t& count);
+
+// End of the last area described by the common header of fru, once the first
+// dataLength bytes hold both the header and that area's length byte.
+inline std::optional<size_t> getFruDataEnd(const std::vector<uint8_t>& fru,
+                                           size_t dataLength)
+{
+    if (fru.size() < sizeof(FRUHeader))
+    {
+        return std::nullopt;
+    }
+    const FRUHeader* header = reinterpret_cast<const FRUHeader*>(fru.data());
+
+    size_t lastRecordStart = std::max(
+        header->internalOffset,
+        std::max(header->chassisOffset,
+                 std::max(header->boardOffset, header->productOffset)));
+    // TODO: Handle Multi-Record FRUs?
+
+    lastRecordStart *= 8; // header starts in are multiples of 8 bytes
+
+    // second byte in record area is the length
+    if (dataLength <= (lastRecordStart + 1) ||
+        fru.size() <= (lastRecordStart + 1))
+    {
+        return std::nullopt;
+    }
+    // it is in multiples of 8 bytes
+    return lastRecordStart + fru[lastRecordStart + 1] * 8;
+}
+
+// Checks the common header checksum, those of the chassis, board and
+// product areas it points to and the header and data checksums of each
+// record in the multirecord area. The internal use area has no checksum.
+inline bool checkFruChecksums(const std::vector<uint8_t>& fru)
+{
+    if (fru.size() < sizeof(FRUHeader))
+    {
+        return false;
+    }
+    auto sum = [&fru](size_t start, size_t length) {
+        return static_cast<uint8_t>(std::accumulate(
+            fru.begin() + start, fru.begin() + start + length, 0));
+    };
+    if (sum(0, sizeof(FRUHeader)) != 0)
+    {
+        return false;
+    }
+    const FRUHeader* header = reinterpret_cast<const FRUHeader*>(fru.data());
+    for (uint8_t offset :
+         {header->chassisOffset, header->boardOffset, header->productOffset})
+    {
+        if (offset == 0)
+        {
+            continue;
+        }
+        // offsets and lengths are in multiples of 8 bytes, the length is
+        // the second byte of the area
+        size_t start = offset * 8;
+        if (fru.size() < start + 2)
+        {
+            return false;
+        }
+        size_t length = fru[start + 1] * 8;
+        if (length == 0 || fru.size() < start + length ||
+            sum(start, length) != 0)
+        {
+            return false;
+        }
+    }
+    if (header->multiRecordOffset == 0)
+    {
+        return true;
+    }
+    // each record has a five byte header: type, end of list flag and format
+    // version, data length, data checksum and header checksum
+    constexpr size_t recordHeaderSize = 5;
+    constexpr uint8_t endOfList = 0x80;
+    constexpr uint8_t recordFormat = 0x02;
+    size_t start = header->multiRecordOffset * 8;
+    while (true)
+    {
+        if (fru.size() < start + recordHeaderSize ||
+            sum(start, recordHeaderSize) != 0 ||
+            (fru[start + 1] & 0x0F) != recordFormat)
+        {
+            return false;
+        }
+        uint8_t flags = fru[start + 1];
+        size_t length = fru[start + 2];
+        uint8_t dataChecksum = fru[start + 3];
+        start += recordHeaderSize;
+        if (fru.size() < start + length ||
+            static_cast<uint8_t>(sum(start, length) + dataChecksum) != 0)
+        {
+            return false;
+        }
+        start += length;
+        if (flags & endOfList)
+        {
+            return true;
+        }
+    }
+}
+} // namespace storage
+} // namespace ipmi
@@ -0,0 +1,87 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Interning of D-Bus object paths and names. Each distinct string is stored
+// once and given a compact id, so caches can be keyed by id and compared as
+// integers instead of each holding their own copy of every path. Entries
+// are never released; the strings seen are bounded by the platform's
+// sensors, FRUs and services.
+namespace ipmi
+{
+namespace intern
+{
+using Id = uint32_t;
+static constexpr Id invalidId = UINT32_MAX;
+
+class Table
+{
+  public:
+    Id intern(std::string_view str)
+    {
+        auto find = ids.find(str);
+        if (find != ids.end())
+        {
+            return find->second;
+        }
+        Id id = static_cast<Id>(strings.size());
+        // deque elements never move, so the key views stay valid
+        const std::string& stored = strings.emplace_back(str);
+        ids.emplace(stored, id);
+        return id;
+    }
+
+    // invalidId for a string that was never interned
+    Id find(std::string_view str) const
+    {
+        auto find = ids.find(str);
+        return find == ids.end() ? invalidId : find->second;
+    }
+
+    const std::string& str(Id id) const
+    {
+        return strings[id];
+    }
+
+    // view of the stored copy, valid for the life of the table
+    std::string_view view(std::string_view str)
+    {
+        return strings[intern(str)];
+    }
+
+    size_t size() const
+    {
+        return strings.size();
+    }
+
+  private:
+    std::deque<std::string> strings;
+    std::unordered_map<std::string_view, Id> ids;
+};
+
+// object paths
+Table& paths();
+
+// service, interface and property names
+Table& names();
+} // namespace intern
+} // namespace ipmi
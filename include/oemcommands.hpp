@@ -40,6 +40,15 @@ enum class IPMINetfnIntelOEMGeneralCmd
     cmdGetProcessorErrConfig = 0x9A,
     cmdSetProcessorErrConfig = 0x9B,
     cmdGetLEDStatus = 0xB0,
+    cmdGetFlightRecorder = 0xE0,
+    cmdGetCacheStats = 0xE1,
+    cmdSetSensorThresholdsBulk = 0xE2,
+    cmdBeginFruWrite = 0xE3,
+    cmdCommitFruWrite = 0xE4,
+    cmdAbortFruWrite = 0xE5,
+    cmdGetSensorReadingHighRes = 0xE6,
+    cmdGetSensorByName = 0xE7,
+    cmdGetPostSettings = 0xE8,
 };
 
 enum class IPMINetfnIntelOEMPlatformCmd
@@ -156,6 +165,9 @@ static constexpr const uint8_t selEvtTargetShift = 4;
 static constexpr const uint8_t targetInstanceMask = 0x0E;
 static constexpr const uint8_t targetInstanceShift = 1;
 
+// entries that fit in one cmdGetFlightRecorder response
+static constexpr const uint8_t maxFlightRecorderEntries = 8;
+
 enum class IPMINetfnIntelOEMAppCmd
 {
     mdrStatus = 0x20,
@@ -312,8 +324,57 @@ struct CfgHostSerialReq
     uint8_t command;
     uint8_t parameter;
 };
+// one flight recorder entry as returned by cmdGetFlightRecorder
+struct FlightRecorderEntry
+{
+    uint64_t timestampUs;
+    uint32_t latencyUs;
+    uint16_t requestLength;
+    uint16_t responseLength;
+    uint16_t dbusCalls;
+    uint8_t channel;
+    uint8_t netfn;
+    uint8_t cmd;
+    uint8_t cc;
+};
+// per cache counters returned by cmdGetCacheStats
+struct CacheStatsRecord
+{
+    uint8_t cacheId;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t refreshes;
+    uint32_t invalidations;
+    uint32_t generation;
+};
+// fixed part of the cmdGetPostSettings response, the BIOS ID follows
+struct PostSettingsRecord
+{
+    uint8_t valid; // PostSettingsValid bits
+    uint16_t powerRestoreDelay;
+    uint8_t shutdownPolicy;
+    uint8_t shutdownPolicySupport;
+    uint8_t resetCfg;
+    uint8_t caterrStatus[maxCPUNum];
+    uint8_t fanProfileFlags; // as in GetFanConfigResp
+    uint16_t cfmLimit;
+    uint16_t cfmMaximum;
+    uint8_t biosIdLength; // full length, at most maxPostBiosIdLength follow
+};
 #pragma pack(pop)
 
+enum class PostSettingsValid : uint8_t
+{
+    powerRestoreDelay = 1 << 0,
+    shutdownPolicy = 1 << 1,
+    processorErrConfig = 1 << 2,
+    fanProfile = 1 << 3,
+    cfm = 1 << 4,
+    biosId = 1 << 5,
+    caterrStatus = 1 << 6,
+};
+static constexpr const uint8_t maxPostBiosIdLength = 64;
+
 enum class setFanProfileFlags : uint8_t
 {
     setFanProfile = 7,
@@ -0,0 +1,163 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <phosphor-logging/log.hpp>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Rate limited logging for error paths a client can hit on every request,
+// like polling a sensor that doesn't exist. Each call site has its own
+// Site, which lets a burst of records through per interval and counts the
+// rest; the next record let through carries that count. Records are handed
+// to a writer thread that sends them to the journal, so the request never
+// waits on journald.
+//
+//   static ipmi::ratelog::Site site("getSensorMap");
+//   ipmi::ratelog::log<phosphor::logging::level::ERR>(
+//       site, "Error getting managed objects",
+//       ipmi::ratelog::entry("CONNECTION=%s", connection.c_str()));
+namespace ipmi
+{
+namespace ratelog
+{
+static constexpr const uint32_t defaultBurst = 5;
+static constexpr const std::chrono::seconds defaultInterval{60};
+
+class Site
+{
+  public:
+    explicit Site(const char* name, uint32_t burst = defaultBurst,
+                  std::chrono::steady_clock::duration interval =
+                      defaultInterval) :
+        siteName(name),
+        burst(burst), interval(interval)
+    {
+    }
+
+    // whether a record at now may be logged, counting it as suppressed if
+    // not
+    bool admit(std::chrono::steady_clock::time_point now)
+    {
+        if (now - windowStart >= interval)
+        {
+            windowStart = now;
+            admitted = 0;
+        }
+        if (admitted < burst)
+        {
+            admitted++;
+            return true;
+        }
+        pending++;
+        total++;
+        return false;
+    }
+
+    // suppressed since the last record let through
+    uint32_t takeSuppressed()
+    {
+        uint32_t count = pending;
+        pending = 0;
+        return count;
+    }
+
+    // suppressed over the site's lifetime
+    uint64_t suppressed() const
+    {
+        return total;
+    }
+
+    const char* name() const
+    {
+        return siteName;
+    }
+
+  private:
+    const char* siteName;
+    uint32_t burst;
+    std::chrono::steady_clock::duration interval;
+    std::chrono::steady_clock::time_point windowStart;
+    uint32_t admitted = 0;
+    uint32_t pending = 0;
+    uint64_t total = 0;
+};
+
+// a journal field, formatted only if its record is let through
+template <typename... Args>
+struct Entry
+{
+    const char* format;
+    std::tuple<Args...> args;
+
+    std::string str() const
+    {
+        return std::apply(
+            [this](const Args&... values) {
+                int size = std::snprintf(nullptr, 0, format, values...);
+                if (size < 0)
+                {
+                    return std::string(format);
+                }
+                std::string field(size, '\0');
+                std::snprintf(field.data(), field.size() + 1, format,
+                              values...);
+                return field;
+            },
+            args);
+    }
+};
+
+template <typename... Args>
+Entry<Args...> entry(const char* format, Args... args)
+{
+    return Entry<Args...>{format, std::make_tuple(args...)};
+}
+
+struct Record
+{
+    int priority;
+    std::string message;
+    std::vector<std::string> fields;
+};
+
+// queues the record for the writer thread, never blocks on the journal
+void submit(Record&& record);
+
+template <phosphor::logging::level L, typename... Entries>
+void log(Site& site, const char* message, const Entries&... entries)
+{
+    if (!site.admit(std::chrono::steady_clock::now()))
+    {
+        return;
+    }
+    Record record{static_cast<int>(L), message, {entries.str()...}};
+    record.fields.emplace_back(std::string("LOG_SITE=") + site.name());
+    uint32_t suppressed = site.takeSuppressed();
+    if (suppressed)
+    {
+        record.fields.emplace_back("SUPPRESSED=" +
+                                   std::to_string(suppressed));
+    }
+    submit(std::move(record));
+}
+} // namespace ratelog
+} // namespace ipmi
@@ -17,15 +17,20 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/bimap.hpp>
 #include <boost/container/flat_map.hpp>
+#include <cachestats.hpp>
 #include <cstring>
+#include <dbusaccounting.hpp>
+#include <flatmaputils.hpp>
+#include <intern.hpp>
 #include <phosphor-logging/log.hpp>
+#include <ratelog.hpp>
 #include <sdbusplus/bus/match.hpp>
 
 #pragma once
 
 struct CmpStrVersion
 {
-    bool operator()(std::string a, std::string b) const
+    bool operator()(const std::string& a, const std::string& b) const
     {
         return strverscmp(a.c_str(), b.c_str()) < 0;
     }
@@ -36,7 +41,8 @@ using SensorSubTree = boost::container::flat_map<
     boost::container::flat_map<std::string, std::vector<std::string>>,
     CmpStrVersion>;
 
-using SensorNumMap = boost::bimap<int, std::string>;
+// sensor number <-> interned sensor path
+using SensorNumMap = boost::bimap<int, ipmi::intern::Id>;
 
 namespace details
 {
@@ -58,20 +64,28 @@ inline static bool getSensorSubtree(std::shared_ptr<SensorSubTree>& subtree)
         dbus,
         "type='signal',member='InterfacesAdded',arg0path='/xyz/openbmc_project/"
         "sensors/'",
-        [](sdbusplus::message::message& m) { sensorTreePtr.reset(); });
+        [](sdbusplus::message::message& m) {
+            sensorTreePtr.reset();
+            ipmi::cache::invalidate(ipmi::cache::CacheId::sdr);
+        });
 
     static sdbusplus::bus::match::match sensorRemoved(
         dbus,
         "type='signal',member='InterfacesRemoved',arg0path='/xyz/"
         "openbmc_project/sensors/'",
-        [](sdbusplus::message::message& m) { sensorTreePtr.reset(); });
+        [](sdbusplus::message::message& m) {
+            sensorTreePtr.reset();
+            ipmi::cache::invalidate(ipmi::cache::CacheId::sdr);
+        });
 
     bool sensorTreeUpdated = false;
     if (sensorTreePtr)
     {
+        ipmi::cache::hit(ipmi::cache::CacheId::sdr);
         subtree = sensorTreePtr;
         return sensorTreeUpdated;
     }
+    ipmi::cache::miss(ipmi::cache::CacheId::sdr);
 
     sensorTreePtr = std::make_shared<SensorSubTree>();
 
@@ -88,8 +102,9 @@ inline static bool getSensorSubtree(std::shared_ptr<SensorSubTree>& subtree)
 
     try
     {
-        auto mapperReply = dbus.call(mapperCall);
-        mapperReply.read(*sensorTreePtr);
+        auto mapperReply = ipmi::accounting::call(dbus, mapperCall);
+        // the mapper replies in strcmp order, the tree is in version order
+        ipmi::readFlatMap(mapperReply, *sensorTreePtr);
     }
     catch (sdbusplus::exception_t& e)
     {
@@ -98,6 +113,7 @@ inline static bool getSensorSubtree(std::shared_ptr<SensorSubTree>& subtree)
     }
     subtree = sensorTreePtr;
     sensorTreeUpdated = true;
+    ipmi::cache::refresh(ipmi::cache::CacheId::sdr);
     return sensorTreeUpdated;
 }
 
@@ -124,8 +140,8 @@ inline static bool getSensorNumMap(std::shared_ptr<SensorNumMap>& sensorNumMap)
     uint8_t sensorNum = 1;
     for (const auto& sensor : *sensorTree)
     {
-        sensorNumMapPtr->insert(
-            SensorNumMap::value_type(sensorNum++, sensor.first));
+        sensorNumMapPtr->insert(SensorNumMap::value_type(
+            sensorNum++, ipmi::intern::paths().intern(sensor.first)));
     }
     sensorNumMap = sensorNumMapPtr;
     sensorNumMapUpated = true;
@@ -213,15 +229,16 @@ inline static uint8_t getSensorNumberFromPath(const std::string& path)
         return 0xFF;
     }
 
-    try
-    {
-        return sensorNumMapPtr->right.at(path);
-    }
-    catch (std::out_of_range& e)
+    auto sensor = sensorNumMapPtr->right.find(ipmi::intern::paths().find(path));
+    if (sensor == sensorNumMapPtr->right.end())
     {
-        phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
+        static ipmi::ratelog::Site site("getSensorNumberFromPath");
+        ipmi::ratelog::log<phosphor::logging::level::ERR>(
+            site, "Sensor path not found",
+            ipmi::ratelog::entry("PATH=%s", path.c_str()));
         return 0xFF;
     }
+    return sensor->second;
 }
 
 inline static uint8_t getSensorEventTypeFromPath(const std::string& path)
@@ -239,13 +256,14 @@ inline static std::string getPathFromSensorNumber(uint8_t sensorNum)
         return std::string();
     }
 
-    try
-    {
-        return sensorNumMapPtr->left.at(sensorNum);
-    }
-    catch (std::out_of_range& e)
+    auto sensor = sensorNumMapPtr->left.find(sensorNum);
+    if (sensor == sensorNumMapPtr->left.end())
     {
-        phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
+        static ipmi::ratelog::Site site("getPathFromSensorNumber");
+        ipmi::ratelog::log<phosphor::logging::level::ERR>(
+            site, "Sensor number not found",
+            ipmi::ratelog::entry("SENSOR_NUMBER=%u", sensorNum));
         return std::string();
     }
+    return ipmi::intern::paths().str(sensor->second);
 }
@@ -0,0 +1,103 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <phosphor-logging/log.hpp>
+#include <ratelog.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Decoding of the IPMI_SEL_* fields the SEL logger stores in the journal
+namespace intel_oem::ipmi::sel
+{
+// journal data is returned as "FIELD=value", only the value is wanted
+inline std::string_view getJournalFieldValue(std::string_view data)
+{
+    data.remove_prefix(std::min(data.find("=") + 1, data.size()));
+    return data;
+}
+
+// std::stoul without the exceptions: leading whitespace, a sign and in base
+// 16 a 0x prefix are accepted and parsing stops at the first character that
+// isn't a digit, false if there is no number or it doesn't fit
+inline bool parseUnsigned(std::string_view str, int base, unsigned long& value)
+{
+    size_t start = str.find_first_not_of(" \f\n\r\t\v");
+    str.remove_prefix(std::min(start, str.size()));
+    bool negative = false;
+    if (!str.empty() && (str.front() == '+' || str.front() == '-'))
+    {
+        negative = str.front() == '-';
+        str.remove_prefix(1);
+    }
+    if (base == 16 && str.size() > 2 && str[0] == '0' &&
+        (str[1] == 'x' || str[1] == 'X') &&
+        std::isxdigit(static_cast<unsigned char>(str[2])))
+    {
+        str.remove_prefix(2);
+    }
+    auto [end, ec] =
+        std::from_chars(str.data(), str.data() + str.size(), value, base);
+    if (ec != std::errc())
+    {
+        return false;
+    }
+    if (negative)
+    {
+        value = -value;
+    }
+    return true;
+}
+
+inline int fromHexStr(const std::string& hexStr, std::vector<uint8_t>& data)
+{
+    static ::ipmi::ratelog::Site site("fromHexStr");
+    for (unsigned int i = 0; i < hexStr.size(); i += 2)
+    {
+        unsigned long value = 0;
+        if (!parseUnsigned(std::string_view(hexStr).substr(i, 2), 16, value))
+        {
+            ::ipmi::ratelog::log<phosphor::logging::level::ERR>(
+                site, "Invalid hex string",
+                ::ipmi::ratelog::entry("HEX_STRING=%s", hexStr.c_str()));
+            return -1;
+        }
+        data.push_back(static_cast<uint8_t>(value));
+    }
+    return 0;
+}
+
+inline int parseJournalInt(const std::string& metadata, const int& base,
+                           int& contents)
+{
+    static ::ipmi::ratelog::Site site("parseJournalInt");
+    unsigned long value = 0;
+    if (!parseUnsigned(metadata, base, value))
+    {
+        ::ipmi::ratelog::log<phosphor::logging::level::ERR>(
+            site, "Invalid journal integer",
+            ::ipmi::ratelog::entry("VALUE=%s", metadata.c_str()));
+        return -1;
+    }
+    contents = static_cast<int>(value);
+    return 0;
+}
+} // namespace intel_oem::ipmi::sel
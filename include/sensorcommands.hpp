@@ -106,6 +106,15 @@ enum class IPMISensorEventEnableByte2 : uint8_t
     sensorScanningEnable = (1 << 6),
 };
 
+// Set Sensor Event Enable byte 2 bits [5:4], what to do with the
+// assertion/deassertion masks that follow
+enum class IPMISensorEventEnableSelected : uint8_t
+{
+    noChange = 0,
+    enableSelected = 1,
+    disableSelected = 2,
+};
+
 enum class IPMISensorEventEnableThresholds : uint8_t
 {
     upperNonRecoverableGoingHigh = (1 << 3),
@@ -129,6 +138,7 @@ enum class IPMINetfnSensorCmds : ipmi_cmd_t
     ipmiCmdReserveDeviceSDRRepo = 0x22,
     ipmiCmdSetSensorThreshold = 0x26,
     ipmiCmdGetSensorThreshold = 0x27,
+    ipmiCmdSetSensorEventEnable = 0x28,
     ipmiCmdGetSensorEventEnable = 0x29,
     ipmiCmdGetSensorEventStatus = 0x2B,
     ipmiCmdGetSensorReading = 0x2D,
@@ -0,0 +1,94 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <array>
+#include <commandutils.hpp>
+#include <cstring>
+#include <dbusarena.hpp>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <variant>
+
+namespace ipmi
+{
+using SensorMap = std::map<std::string, std::map<std::string, DbusVariant>>;
+
+// Sensor services export associations, decorators and more on every sensor,
+// the handlers only read these.
+static constexpr std::array<const char*, 3> sensorInterfaces = {
+    "xyz.openbmc_project.Sensor.Value",
+    "xyz.openbmc_project.Sensor.Threshold.Warning",
+    "xyz.openbmc_project.Sensor.Threshold.Critical"};
+
+inline bool isSensorInterface(const char* interface)
+{
+    for (const char* wanted : sensorInterfaces)
+    {
+        if (std::strcmp(interface, wanted) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Decodes a GetManagedObjects reply into the arena, keeping only objects
+// implementing a sensor interface and only those interfaces of them. Other
+// interfaces are skipped in place instead of being materialized.
+inline int readSensorObjects(sd_bus_message* m, arena::RefreshArena& arena,
+                             arena::ObjectMap& objects)
+{
+    return arena::readManagedObjects(m, arena, objects, isSensorInterface);
+}
+
+inline DbusVariant toDbusVariant(const arena::Value& value)
+{
+    return std::visit(
+        [](const auto& data) -> DbusVariant {
+            using T = std::decay_t<decltype(data)>;
+            if constexpr (std::is_same_v<T, std::string_view>)
+            {
+                return std::string(data);
+            }
+            else
+            {
+                return data;
+            }
+        },
+        value);
+}
+
+// Copies one decoded sensor out of the arena for the handlers. The handlers
+// and the SDR builders in sensorsdr.hpp all read sensors through SensorMap,
+// so it is kept as their interface; only the sensor being served is
+// converted, the rest of the connection stays in the arena. The copy also
+// outlives the arena, which the next refresh resets.
+inline void toSensorMap(const arena::InterfaceMap& interfaces,
+                        SensorMap& sensorMap)
+{
+    sensorMap.clear();
+    for (const auto& [interface, properties] : interfaces)
+    {
+        auto& target = sensorMap[std::string(interface)];
+        for (const auto& [name, value] : properties)
+        {
+            target.emplace(std::string(name), toDbusVariant(value));
+        }
+    }
+}
+} // namespace ipmi
@@ -15,10 +15,18 @@
 */
 
 #pragma once
+#include <algorithm>
+#include <array>
+#include <boost/container/flat_map.hpp>
+#include <cctype>
 #include <cmath>
+#include <intern.hpp>
 #include <iostream>
 #include <ipmid/api.hpp>
+#include <limits>
+#include <optional>
 #include <phosphor-logging/log.hpp>
+#include <string_view>
 
 namespace ipmi
 {
@@ -138,7 +146,8 @@ static inline bool getSensorAttributes(const double max, const double min,
     return true;
 }
 
-static inline uint8_t
+// nullopt when value doesn't fit the sensor's byte
+static inline std::optional<uint8_t>
     scaleIPMIValueFromDouble(const double value, const uint16_t mValue,
                              const int8_t rExp, const uint16_t bValue,
                              const int8_t bExp, const bool bSigned)
@@ -150,7 +159,7 @@ static inline uint8_t
     if (scaledValue > std::numeric_limits<uint8_t>::max() ||
         scaledValue < std::numeric_limits<uint8_t>::lowest())
     {
-        throw std::out_of_range("Value out of range");
+        return std::nullopt;
     }
     if (bSigned)
     {
@@ -162,8 +171,8 @@ static inline uint8_t
     }
 }
 
-static inline uint8_t getScaledIPMIValue(const double value, const double max,
-                                         const double min)
+static inline std::optional<uint8_t>
+    getScaledIPMIValue(const double value, const double max, const double min)
 {
     int16_t mValue = 0;
     int8_t rExp = 0;
@@ -175,9 +184,70 @@ static inline uint8_t getScaledIPMIValue(const double value, const double max,
     result = getSensorAttributes(max, min, mValue, rExp, bValue, bExp, bSigned);
     if (!result)
     {
-        throw std::runtime_error("Illegal sensor attributes");
+        return std::nullopt;
     }
     return scaleIPMIValueFromDouble(value, mValue, rExp, bValue, bExp, bSigned);
 }
 
+// Whether a sensor is on a gated rail, by the words of its label: a word
+// that is one of the gated prefixes, optionally followed by digits, e.g.
+// CPU1_Temp, DIMM_A1 or VR_CPU1_VCCIN, but not Vref or CpuFan.
+static inline bool isPowerGatedLabel(std::string_view path)
+{
+    static constexpr std::array<std::string_view, 4> gatedPrefixes = {
+        "CPU", "DIMM", "VR", "PCH"};
+
+    auto isGatedWord = [](std::string_view word) {
+        for (std::string_view prefix : gatedPrefixes)
+        {
+            if (word.substr(0, prefix.size()) == prefix &&
+                std::all_of(word.begin() + prefix.size(), word.end(),
+                            [](char c) {
+                                return std::isdigit(
+                                    static_cast<unsigned char>(c));
+                            }))
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+    std::string_view label = path.substr(path.rfind('/') + 1);
+    while (!label.empty())
+    {
+        size_t end = label.find_first_of("_ ");
+        if (isGatedWord(label.substr(0, end)))
+        {
+            return true;
+        }
+        label.remove_prefix(end == std::string_view::npos ? label.size()
+                                                          : end + 1);
+    }
+    return false;
+}
+
+// Labels don't change for a path, so whether it is gated is worked out once
+// per interned path
+class PowerGateCache
+{
+  public:
+    bool isGated(intern::Id pathId, std::string_view path)
+    {
+        auto cached = gated.find(pathId);
+        if (cached != gated.end())
+        {
+            return cached->second;
+        }
+        return gated.emplace(pathId, isPowerGatedLabel(path)).first->second;
+    }
+
+    size_t size() const
+    {
+        return gated.size();
+    }
+
+  private:
+    boost::container::flat_map<intern::Id, bool> gated;
+};
+
 } // namespace ipmi
@@ -211,13 +211,3 @@ struct FRUHeader
     uint8_t checksum;
 };
 #pragma pack(pop)
-
-namespace ipmi
-{
-namespace storage
-{
-ipmi_ret_t getFruSdrs(size_t index, get_sdr::SensorDataFruRecord& resp);
-
-ipmi_ret_t getFruSdrCount(size_t& count);
-} // namespace storage
-} // namespace ipmi
@@ -0,0 +1,49 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+
+// USDT static probes under the "intel_ipmi_oem" provider, usable from
+// SystemTap, bpftrace or perf. A disarmed probe is a single nop, so they are
+// left in release builds; without <sys/sdt.h> they compile away entirely.
+//
+//   handler_entry(netfn, cmd)
+//   handler_exit(netfn, cmd, cc, elapsed_us)
+//   sensor_cache_hit(connection, path) / sensor_cache_miss(connection, path)
+//   fru_cache_hit(dev_id) / fru_cache_miss(dev_id)
+//   sel_scan_start(cmd) / sel_scan_end(cmd, entries)
+//   dbus_call_start(service) / dbus_call_end(service, elapsed_us)
+#ifdef IPMI_TRACEPOINTS
+#include <sys/sdt.h>
+
+#define IPMI_PROBE1(name, a) DTRACE_PROBE1(intel_ipmi_oem, name, a)
+#define IPMI_PROBE2(name, a, b) DTRACE_PROBE2(intel_ipmi_oem, name, a, b)
+#define IPMI_PROBE4(name, a, b, c, d)                                          \
+    DTRACE_PROBE4(intel_ipmi_oem, name, a, b, c, d)
+#else
+#define IPMI_PROBE1(name, a)                                                   \
+    do                                                                         \
+    {                                                                          \
+    } while (0)
+#define IPMI_PROBE2(name, a, b)                                                \
+    do                                                                         \
+    {                                                                          \
+    } while (0)
+#define IPMI_PROBE4(name, a, b, c, d)                                          \
+    do                                                                         \
+    {                                                                          \
+    } while (0)
+#endif
@@ -0,0 +1,45 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <ipmid/types.hpp>
+#include <optional>
+#include <sdbusplus/bus.hpp>
+#include <string>
+
+// Write-behind for the settings BIOS sets while booting. The set command
+// validates its request, queues the property writes and replies; the queue
+// is applied in order from the event loop once the response is out. The
+// matching get commands look at the queue first so they see a write before
+// it lands, writes that fail are logged to the journal.
+namespace ipmi
+{
+namespace writebehind
+{
+// the owning service is looked up when the write is applied
+void queue(sdbusplus::bus::bus& bus, const std::string& path,
+           const std::string& interface, const std::string& property,
+           const Value& value);
+
+// newest queued value of a property, nullopt once it has been applied
+std::optional<Value> pending(const std::string& path,
+                             const std::string& interface,
+                             const std::string& property);
+
+// applies everything queued, normally run from the event loop
+void flush();
+} // namespace writebehind
+} // namespace ipmi
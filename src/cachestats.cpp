@@ -0,0 +1,68 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <array>
+#include <cachestats.hpp>
+
+namespace ipmi
+{
+namespace cache
+{
+static std::array<CacheCounters, cacheCount> counters;
+
+static CacheCounters& countersFor(CacheId id)
+{
+    return counters[static_cast<size_t>(id)];
+}
+
+void hit(CacheId id)
+{
+    countersFor(id).hits++;
+}
+
+void miss(CacheId id)
+{
+    countersFor(id).misses++;
+}
+
+void refresh(CacheId id)
+{
+    countersFor(id).refreshes++;
+    countersFor(id).generation++;
+}
+
+void invalidate(CacheId id)
+{
+    countersFor(id).invalidations++;
+    countersFor(id).generation++;
+}
+
+CacheCounters getCounters(CacheId id)
+{
+    return countersFor(id);
+}
+
+void resetCounters()
+{
+    for (CacheCounters& cache : counters)
+    {
+        uint32_t generation = cache.generation;
+        cache = CacheCounters();
+        cache.generation = generation;
+    }
+}
+} // namespace cache
+} // namespace ipmi
@@ -0,0 +1,165 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <boost/container/flat_map.hpp>
+#include <commandstats.hpp>
+#include <dbusaccounting.hpp>
+#include <flightrecorder.hpp>
+#include <fstream>
+#include <iomanip>
+#include <ipmid/api.hpp>
+#include <memory>
+#include <phosphor-logging/log.hpp>
+#include <sdbusplus/asio/object_server.hpp>
+#include <tuple>
+#include <vector>
+
+namespace ipmi
+{
+namespace stats
+{
+// netfn, cmd, count, errors, mean, p50, p99, max
+using CommandSummary = std::tuple<uint8_t, uint8_t, uint64_t, uint64_t,
+                                  uint64_t, uint64_t, uint64_t, uint64_t>;
+
+// keyed by netfn << 8 | cmd, values are held by pointer so references handed
+// out at registration time survive later inserts
+static boost::container::flat_map<uint16_t, std::unique_ptr<CommandHistogram>>
+    histograms;
+
+static std::unique_ptr<sdbusplus::asio::object_server> statsServer;
+static std::shared_ptr<sdbusplus::asio::dbus_interface> statsIface;
+
+static std::vector<CommandSummary> getCommandSummaries()
+{
+    std::vector<CommandSummary> summaries;
+    summaries.reserve(histograms.size());
+    for (const auto& [key, histogram] : histograms)
+    {
+        uint64_t mean = 0;
+        if (histogram->count)
+        {
+            mean = histogram->totalUs / histogram->count;
+        }
+        summaries.emplace_back(static_cast<uint8_t>(key >> 8),
+                               static_cast<uint8_t>(key & 0xFF),
+                               histogram->count, histogram->errors, mean,
+                               histogram->percentile(50),
+                               histogram->percentile(99), histogram->maxUs);
+    }
+    return summaries;
+}
+
+static void createStatsInterface()
+{
+    if (statsIface)
+    {
+        return;
+    }
+
+    flight::registerDumpSignal();
+
+    std::shared_ptr<sdbusplus::asio::connection> conn = getSdBus();
+    if (!conn)
+    {
+        return;
+    }
+    statsServer = std::make_unique<sdbusplus::asio::object_server>(conn);
+    statsIface = statsServer->add_interface(statsPath, statsIntf);
+
+    statsIface->register_method("GetSummary", []() {
+        return getCommandSummaries();
+    });
+    statsIface->register_method("GetHistogram", [](uint8_t netfn,
+                                                   uint8_t cmd) {
+        std::vector<uint64_t> buckets;
+        auto it = histograms.find(static_cast<uint16_t>(netfn << 8 | cmd));
+        if (it != histograms.end())
+        {
+            buckets.assign(it->second->buckets.begin(),
+                           it->second->buckets.end());
+        }
+        return buckets;
+    });
+    statsIface->register_method("Dump", []() {
+        return dumpCommandHistograms(statsDumpFile);
+    });
+    statsIface->register_method("Reset", []() { resetCommandHistograms(); });
+    statsIface->register_property(
+        "SlowRequestThresholdUs", accounting::getSlowRequestThreshold(),
+        [](const uint64_t& req, uint64_t& property) {
+            accounting::setSlowRequestThreshold(req);
+            property = req;
+            return 1;
+        });
+    statsIface->initialize();
+}
+
+CommandHistogram& getCommandHistogram(uint8_t netfn, uint8_t cmd)
+{
+    createStatsInterface();
+
+    std::unique_ptr<CommandHistogram>& histogram =
+        histograms[static_cast<uint16_t>(netfn << 8 | cmd)];
+    if (!histogram)
+    {
+        histogram = std::make_unique<CommandHistogram>();
+    }
+    return *histogram;
+}
+
+void resetCommandHistograms()
+{
+    for (auto& [key, histogram] : histograms)
+    {
+        *histogram = CommandHistogram();
+    }
+}
+
+bool dumpCommandHistograms(const std::string& path)
+{
+    std::ofstream output(path, std::ios::trunc);
+    if (!output.good())
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Failed to open command stats dump file",
+            phosphor::logging::entry("PATH=%s", path.c_str()));
+        return false;
+    }
+
+    output << "# netfn cmd count errors mean_us p50_us p99_us max_us : "
+              "log2 us buckets\n";
+    for (const auto& [key, histogram] : histograms)
+    {
+        output << "0x" << std::hex << std::setw(2) << std::setfill('0')
+               << (key >> 8) << " 0x" << std::setw(2) << (key & 0xFF)
+               << std::dec << " " << histogram->count << " "
+               << histogram->errors << " "
+               << (histogram->count ? histogram->totalUs / histogram->count
+                                    : 0)
+               << " " << histogram->percentile(50) << " "
+               << histogram->percentile(99) << " " << histogram->maxUs
+               << " :";
+        for (uint64_t bucket : histogram->buckets)
+        {
+            output << " " << bucket;
+        }
+        output << "\n";
+    }
+    return output.good();
+}
+} // namespace stats
+} // namespace ipmi
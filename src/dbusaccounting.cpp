@@ -0,0 +1,139 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <boost/container/flat_map.hpp>
+#include <dbusaccounting.hpp>
+#include <exception>
+#include <functional>
+#include <phosphor-logging/log.hpp>
+#include <string>
+
+namespace ipmi
+{
+namespace accounting
+{
+struct ServiceCalls
+{
+    uint32_t count = 0;
+    uint64_t totalUs = 0;
+    uint64_t maxUs = 0;
+};
+
+struct RequestAccounting
+{
+    bool active = false;
+    uint8_t netfn = 0;
+    uint8_t cmd = 0;
+    uint32_t calls = 0;
+    uint64_t totalUs = 0;
+    boost::container::flat_map<std::string, ServiceCalls, std::less<>>
+        services;
+};
+
+// ipmid handles one request at a time, so a single slot is enough
+static RequestAccounting current;
+static uint64_t slowRequestThresholdUs = defaultSlowRequestThresholdUs;
+
+void beginRequest(uint8_t netfn, uint8_t cmd)
+{
+    current.active = true;
+    current.netfn = netfn;
+    current.cmd = cmd;
+    current.calls = 0;
+    current.totalUs = 0;
+    current.services.clear();
+}
+
+void endRequest(uint64_t elapsedUs) noexcept
+{
+    current.active = false;
+    if (elapsedUs < slowRequestThresholdUs)
+    {
+        return;
+    }
+
+    try
+    {
+        std::string summary;
+        for (const auto& [service, calls] : current.services)
+        {
+            if (!summary.empty())
+            {
+                summary += ", ";
+            }
+            summary += service + ": " + std::to_string(calls.count) +
+                       " calls " + std::to_string(calls.totalUs) + "us (max " +
+                       std::to_string(calls.maxUs) + "us)";
+        }
+
+        phosphor::logging::log<phosphor::logging::level::WARNING>(
+            "Slow IPMI request",
+            phosphor::logging::entry("NETFN=0x%02x", current.netfn),
+            phosphor::logging::entry("CMD=0x%02x", current.cmd),
+            phosphor::logging::entry(
+                "DURATION_US=%llu", static_cast<unsigned long long>(elapsedUs)),
+            phosphor::logging::entry("DBUS_CALLS=%u", current.calls),
+            phosphor::logging::entry(
+                "DBUS_US=%llu",
+                static_cast<unsigned long long>(current.totalUs)),
+            phosphor::logging::entry("DBUS_SERVICES=%s", summary.c_str()));
+    }
+    catch (const std::exception&)
+    {
+        // the summary is best effort, the request is closed regardless
+    }
+}
+
+void recordDbusCall(std::string_view service, uint64_t elapsedUs)
+{
+    if (!current.active)
+    {
+        return;
+    }
+    current.calls++;
+    current.totalUs += elapsedUs;
+
+    auto calls = current.services.find(service);
+    if (calls == current.services.end())
+    {
+        calls =
+            current.services.emplace(std::string(service), ServiceCalls())
+                .first;
+    }
+    calls->second.count++;
+    calls->second.totalUs += elapsedUs;
+    if (elapsedUs > calls->second.maxUs)
+    {
+        calls->second.maxUs = elapsedUs;
+    }
+}
+
+uint32_t requestDbusCalls()
+{
+    return current.calls;
+}
+
+uint64_t getSlowRequestThreshold()
+{
+    return slowRequestThresholdUs;
+}
+
+void setSlowRequestThreshold(uint64_t thresholdUs)
+{
+    slowRequestThresholdUs = thresholdUs;
+}
+} // namespace accounting
+} // namespace ipmi
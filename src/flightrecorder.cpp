@@ -0,0 +1,99 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <boost/asio/signal_set.hpp>
+#include <csignal>
+#include <flightrecorder.hpp>
+#include <fstream>
+#include <iomanip>
+#include <ipmid/api.hpp>
+#include <memory>
+#include <phosphor-logging/log.hpp>
+
+namespace ipmi
+{
+namespace flight
+{
+static Ring<Entry, flightRecorderEntries> recorder;
+static std::unique_ptr<boost::asio::signal_set> dumpSignal;
+
+void record(const Entry& entry)
+{
+    recorder.push(entry);
+}
+
+std::vector<Entry> snapshot()
+{
+    return recorder.snapshot();
+}
+
+bool dump(const std::string& path)
+{
+    std::ofstream output(path, std::ios::trunc);
+    if (!output.good())
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Failed to open flight recorder dump file",
+            phosphor::logging::entry("PATH=%s", path.c_str()));
+        return false;
+    }
+
+    output << "# timestamp_us channel netfn cmd req_len rsp_len cc "
+              "latency_us dbus_calls\n";
+    for (const Entry& entry : recorder.snapshot())
+    {
+        output << std::dec << entry.timestampUs << " "
+               << static_cast<int>(entry.channel) << std::hex
+               << std::setfill('0') << " 0x" << std::setw(2)
+               << static_cast<int>(entry.netfn) << " 0x" << std::setw(2)
+               << static_cast<int>(entry.cmd) << std::dec << " "
+               << entry.requestLength << " " << entry.responseLength
+               << std::hex << " 0x" << std::setw(2)
+               << static_cast<int>(entry.cc) << std::dec << " "
+               << entry.latencyUs << " " << entry.dbusCalls << "\n";
+    }
+    return output.good();
+}
+
+static void waitForDumpSignal()
+{
+    dumpSignal->async_wait(
+        [](const boost::system::error_code& ec, int signalNumber) {
+            if (ec)
+            {
+                return;
+            }
+            dump(flightRecorderDumpFile);
+            waitForDumpSignal();
+        });
+}
+
+void registerDumpSignal()
+{
+    if (dumpSignal)
+    {
+        return;
+    }
+    std::shared_ptr<boost::asio::io_context> io = getIo();
+    if (!io)
+    {
+        return;
+    }
+    dumpSignal = std::make_unique<boost::asio::signal_set>(*io, SIGUSR2);
+    waitForDumpSignal();
+}
+} // namespace flight
+} // namespace ipmi
@@ -0,0 +1,36 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <intern.hpp>
+
+namespace ipmi
+{
+namespace intern
+{
+// shared by all providers, so ids mean the same in every cache
+Table& paths()
+{
+    static Table table;
+    return table;
+}
+
+Table& names()
+{
+    static Table table;
+    return table;
+}
+} // namespace intern
+} // namespace ipmi
@@ -23,17 +23,26 @@
 #include <boost/container/flat_map.hpp>
 #include <boost/process/child.hpp>
 #include <boost/process/io.hpp>
+#include <cachestats.hpp>
 #include <commandutils.hpp>
+#include <cstring>
+#include <dbusarena.hpp>
+#include <flightrecorder.hpp>
 #include <iostream>
 #include <ipmid/api.hpp>
 #include <ipmid/utils.hpp>
+#include <memory>
 #include <oemcommands.hpp>
+#include <optional>
 #include <phosphor-logging/log.hpp>
+#include <ratelog.hpp>
 #include <sdbusplus/bus.hpp>
+#include <sdbusplus/bus/match.hpp>
 #include <sdbusplus/message/types.hpp>
 #include <string>
 #include <variant>
 #include <vector>
+#include <writebehind.hpp>
 
 namespace ipmi
 {
@@ -47,24 +56,51 @@ static constexpr auto networkIPIntf = "xyz.openbmc_project.Network.IP";
 static constexpr auto networkService = "xyz.openbmc_project.Network";
 static constexpr auto networkRoot = "/xyz/openbmc_project/network";
 
+static constexpr const char* fruDeviceIntf = "xyz.openbmc_project.FruDevice";
+
+// FruDevice objects are decoded into this on every lookup and dropped
+// before the next one
+static arena::RefreshArena fruArena;
+
+static bool isFruDeviceInterface(const char* interface)
+{
+    return std::strcmp(interface, fruDeviceIntf) == 0;
+}
+
 // return code: 0 successful
 int8_t getChassisSerialNumber(sdbusplus::bus::bus& bus, std::string& serial)
 {
     std::string objpath = "/xyz/openbmc_project/FruDevice";
     std::string intf = "xyz.openbmc_project.FruDeviceManager";
-    std::string service = getService(bus, intf, objpath);
-    ObjectValueTree valueTree = getManagedObjects(bus, service, "/");
+    std::string service = accounting::getService(bus, intf, objpath);
+    auto getObjects =
+        bus.new_method_call(service.c_str(), "/",
+                            "org.freedesktop.DBus.ObjectManager",
+                            "GetManagedObjects");
+    auto reply = accounting::call(bus, getObjects);
+
+    fruArena.reset();
+    arena::ObjectMap valueTree(fruArena.resource());
+    int r = arena::readManagedObjects(reply.get(), fruArena, valueTree,
+                                      isFruDeviceInterface);
+    if (r < 0)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Error decoding FRU device objects",
+            phosphor::logging::entry("ERRNO=%d", -r));
+        return -1;
+    }
     if (valueTree.empty())
     {
         phosphor::logging::log<phosphor::logging::level::ERR>(
             "No object implements interface",
-            phosphor::logging::entry("INTF=%s", intf.c_str()));
+            phosphor::logging::entry("INTF=%s", fruDeviceIntf));
         return -1;
     }
 
     for (const auto& item : valueTree)
     {
-        auto interface = item.second.find("xyz.openbmc_project.FruDevice");
+        auto interface = item.second.find(fruDeviceIntf);
         if (interface == item.second.end())
         {
             continue;
@@ -76,25 +112,21 @@ int8_t getChassisSerialNumber(sdbusplus::bus::bus& bus, std::string& serial)
             continue;
         }
 
-        try
+        auto result = std::get_if<std::string_view>(&property->second);
+        if (result == nullptr)
         {
-            Value variant = property->second;
-            std::string& result =
-                sdbusplus::message::variant_ns::get<std::string>(variant);
-            if (result.size() > maxFRUStringLength)
-            {
-                phosphor::logging::log<phosphor::logging::level::ERR>(
-                    "FRU serial number exceed maximum length");
-                return -1;
-            }
-            serial = result;
-            return 0;
+            phosphor::logging::log<phosphor::logging::level::ERR>(
+                "FRU serial number is not a string");
+            return -1;
         }
-        catch (sdbusplus::message::variant_ns::bad_variant_access& e)
+        if (result->size() > maxFRUStringLength)
         {
-            phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
+            phosphor::logging::log<phosphor::logging::level::ERR>(
+                "FRU serial number exceed maximum length");
             return -1;
         }
+        serial = *result;
+        return 0;
     }
     return -1;
 }
@@ -164,8 +196,7 @@ ipmi_ret_t ipmiOEMSetSystemGUID(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
 
     std::string objpath = "/xyz/openbmc_project/control/host0/systemGUID";
     std::string intf = "xyz.openbmc_project.Common.UUID";
-    std::string service = getService(dbus, intf, objpath);
-    setDbusProperty(dbus, service, objpath, intf, "UUID", guid);
+    writebehind::queue(dbus, objpath, intf, "UUID", guid);
     return IPMI_CC_OK;
 }
 
@@ -182,8 +213,7 @@ ipmi_ret_t ipmiOEMSetBIOSID(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     }
     std::string idString((char*)data->biosId, data->biosIDLength);
 
-    std::string service = getService(dbus, biosIntf, biosObjPath);
-    setDbusProperty(dbus, service, biosObjPath, biosIntf, biosProp, idString);
+    writebehind::queue(dbus, biosObjPath, biosIntf, biosProp, idString);
     uint8_t* bytesWritten = static_cast<uint8_t*>(response);
     *bytesWritten =
         data->biosIDLength; // how many bytes are written into storage
@@ -222,11 +252,22 @@ ipmi_ret_t ipmiOEMGetDeviceInfo(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                 return IPMI_CC_REQ_DATA_LEN_INVALID;
             }
 
-            std::string service = getService(dbus, biosIntf, biosObjPath);
             try
             {
-                Value variant = getDbusProperty(dbus, service, biosObjPath,
-                                                biosIntf, biosProp);
+                std::optional<Value> queued =
+                    writebehind::pending(biosObjPath, biosIntf, biosProp);
+                Value variant;
+                if (queued)
+                {
+                    variant = *queued;
+                }
+                else
+                {
+                    std::string service =
+                        accounting::getService(dbus, biosIntf, biosObjPath);
+                    variant = accounting::getDbusProperty(
+                        dbus, service, biosObjPath, biosIntf, biosProp);
+                }
                 std::string& idString =
                     sdbusplus::message::variant_ns::get<std::string>(variant);
                 if (req->offset >= idString.size())
@@ -299,11 +340,21 @@ ipmi_ret_t ipmiOEMGetPowerRestoreDelay(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         return IPMI_CC_REQ_DATA_LEN_INVALID;
     }
 
-    std::string service =
-        getService(dbus, powerRestoreDelayIntf, powerRestoreDelayObjPath);
-    Value variant =
-        getDbusProperty(dbus, service, powerRestoreDelayObjPath,
-                        powerRestoreDelayIntf, powerRestoreDelayProp);
+    std::optional<Value> queued = writebehind::pending(
+        powerRestoreDelayObjPath, powerRestoreDelayIntf, powerRestoreDelayProp);
+    Value variant;
+    if (queued)
+    {
+        variant = *queued;
+    }
+    else
+    {
+        std::string service = accounting::getService(
+            dbus, powerRestoreDelayIntf, powerRestoreDelayObjPath);
+        variant = accounting::getDbusProperty(
+            dbus, service, powerRestoreDelayObjPath, powerRestoreDelayIntf,
+            powerRestoreDelayProp);
+    }
 
     uint16_t delay = sdbusplus::message::variant_ns::get<uint16_t>(variant);
     resp->byteLSB = delay;
@@ -428,15 +479,16 @@ ipmi_ret_t ipmiOEMSetPowerRestoreDelay(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     }
     delay = data->byteMSB;
     delay = (delay << 8) | data->byteLSB;
-    std::string service =
-        getService(dbus, powerRestoreDelayIntf, powerRestoreDelayObjPath);
-    setDbusProperty(dbus, service, powerRestoreDelayObjPath,
-                    powerRestoreDelayIntf, powerRestoreDelayProp, delay);
+    writebehind::queue(dbus, powerRestoreDelayObjPath, powerRestoreDelayIntf,
+                       powerRestoreDelayProp, delay);
     *dataLen = 0;
 
     return IPMI_CC_OK;
 }
 
+// CATERRStatus from the Get POST Settings snapshot, nullopt until it is read
+static std::optional<std::vector<uint8_t>> getCaterrStatusSnapshot();
+
 ipmi_ret_t ipmiOEMGetProcessorErrConfig(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                                         ipmi_request_t request,
                                         ipmi_response_t response,
@@ -452,36 +504,62 @@ ipmi_ret_t ipmiOEMGetProcessorErrConfig(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         return IPMI_CC_REQ_DATA_LEN_INVALID;
     }
 
-    std::string service =
-        getService(dbus, processorErrConfigIntf, processorErrConfigObjPath);
-    Value variant = getDbusProperty(dbus, service, processorErrConfigObjPath,
-                                    processorErrConfigIntf, "ResetCfg");
-    resp->resetCfg = sdbusplus::message::variant_ns::get<uint8_t>(variant);
+    // the queue is checked before any D-Bus call; with a write queued,
+    // CATERRStatus comes from the POST settings snapshot when it holds one,
+    // so the read-back needs no D-Bus at all
+    std::optional<Value> queued = writebehind::pending(
+        processorErrConfigObjPath, processorErrConfigIntf, "ResetCfg");
+    std::optional<std::vector<uint8_t>> snapshotCaterr;
+    if (queued)
+    {
+        resp->resetCfg = sdbusplus::message::variant_ns::get<uint8_t>(*queued);
+        snapshotCaterr = getCaterrStatusSnapshot();
+    }
 
     std::vector<uint8_t> caterrStatus;
-    sdbusplus::message::variant<std::vector<uint8_t>> message;
-
-    auto method =
-        dbus.new_method_call(service.c_str(), processorErrConfigObjPath,
-                             "org.freedesktop.DBus.Properties", "Get");
-
-    method.append(processorErrConfigIntf, "CATERRStatus");
-    auto reply = dbus.call(method);
-
-    try
+    if (snapshotCaterr)
     {
-        reply.read(message);
-        caterrStatus =
-            sdbusplus::message::variant_ns::get<std::vector<uint8_t>>(message);
+        caterrStatus = std::move(*snapshotCaterr);
     }
-    catch (sdbusplus::exception_t&)
+    else
     {
-        phosphor::logging::log<phosphor::logging::level::ERR>(
-            "ipmiOEMGetProcessorErrConfig: error on dbus",
-            phosphor::logging::entry("PRORPERTY=CATERRStatus"),
-            phosphor::logging::entry("PATH=%s", processorErrConfigObjPath),
-            phosphor::logging::entry("INTERFACE=%s", processorErrConfigIntf));
-        return IPMI_CC_UNSPECIFIED_ERROR;
+        std::string service = accounting::getService(
+            dbus, processorErrConfigIntf, processorErrConfigObjPath);
+        if (!queued)
+        {
+            Value variant = accounting::getDbusProperty(
+                dbus, service, processorErrConfigObjPath,
+                processorErrConfigIntf, "ResetCfg");
+            resp->resetCfg =
+                sdbusplus::message::variant_ns::get<uint8_t>(variant);
+        }
+
+        sdbusplus::message::variant<std::vector<uint8_t>> message;
+
+        auto method =
+            dbus.new_method_call(service.c_str(), processorErrConfigObjPath,
+                                 "org.freedesktop.DBus.Properties", "Get");
+
+        method.append(processorErrConfigIntf, "CATERRStatus");
+        auto reply = accounting::call(dbus, method);
+
+        try
+        {
+            reply.read(message);
+            caterrStatus =
+                sdbusplus::message::variant_ns::get<std::vector<uint8_t>>(
+                    message);
+        }
+        catch (sdbusplus::exception_t&)
+        {
+            phosphor::logging::log<phosphor::logging::level::ERR>(
+                "ipmiOEMGetProcessorErrConfig: error on dbus",
+                phosphor::logging::entry("PRORPERTY=CATERRStatus"),
+                phosphor::logging::entry("PATH=%s", processorErrConfigObjPath),
+                phosphor::logging::entry("INTERFACE=%s",
+                                         processorErrConfigIntf));
+            return IPMI_CC_UNSPECIFIED_ERROR;
+        }
     }
 
     size_t len =
@@ -507,14 +585,11 @@ ipmi_ret_t ipmiOEMSetProcessorErrConfig(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         *dataLen = 0;
         return IPMI_CC_REQ_DATA_LEN_INVALID;
     }
-    std::string service =
-        getService(dbus, processorErrConfigIntf, processorErrConfigObjPath);
-    setDbusProperty(dbus, service, processorErrConfigObjPath,
-                    processorErrConfigIntf, "ResetCfg", req->resetCfg);
-
-    setDbusProperty(dbus, service, processorErrConfigObjPath,
-                    processorErrConfigIntf, "ResetErrorOccurrenceCounts",
-                    req->resetErrorOccurrenceCounts);
+    writebehind::queue(dbus, processorErrConfigObjPath, processorErrConfigIntf,
+                       "ResetCfg", req->resetCfg);
+    writebehind::queue(dbus, processorErrConfigObjPath, processorErrConfigIntf,
+                       "ResetErrorOccurrenceCounts",
+                       req->resetErrorOccurrenceCounts);
     *dataLen = 0;
 
     return IPMI_CC_OK;
@@ -541,11 +616,23 @@ ipmi_ret_t ipmiOEMGetShutdownPolicy(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
 
     try
     {
-        std::string service =
-            getService(dbus, oemShutdownPolicyIntf, oemShutdownPolicyObjPath);
-        Value variant = getDbusProperty(dbus, service, oemShutdownPolicyObjPath,
-                                        oemShutdownPolicyIntf,
-                                        oemShutdownPolicyObjPathProp);
+        std::optional<Value> queued =
+            writebehind::pending(oemShutdownPolicyObjPath,
+                                 oemShutdownPolicyIntf,
+                                 oemShutdownPolicyObjPathProp);
+        Value variant;
+        if (queued)
+        {
+            variant = *queued;
+        }
+        else
+        {
+            std::string service = accounting::getService(
+                dbus, oemShutdownPolicyIntf, oemShutdownPolicyObjPath);
+            variant = accounting::getDbusProperty(
+                dbus, service, oemShutdownPolicyObjPath, oemShutdownPolicyIntf,
+                oemShutdownPolicyObjPathProp);
+        }
         resp->policy = sdbusplus::message::variant_ns::get<uint8_t>(variant);
         // TODO needs to check if it is multi-node products,
         // policy is only supported on node 3/4
@@ -587,20 +674,8 @@ ipmi_ret_t ipmiOEMSetShutdownPolicy(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         return IPMI_CC_INVALID_FIELD_REQUEST;
     }
 
-    try
-    {
-        std::string service =
-            getService(dbus, oemShutdownPolicyIntf, oemShutdownPolicyObjPath);
-        setDbusProperty(dbus, service, oemShutdownPolicyObjPath,
-                        oemShutdownPolicyIntf, oemShutdownPolicyObjPathProp,
-                        *req);
-    }
-    catch (sdbusplus::exception_t& e)
-    {
-        phosphor::logging::log<phosphor::logging::level::ERR>(e.description());
-        return IPMI_CC_UNSPECIFIED_ERROR;
-    }
-
+    writebehind::queue(dbus, oemShutdownPolicyObjPath, oemShutdownPolicyIntf,
+                       oemShutdownPolicyObjPathProp, *req);
     return IPMI_CC_OK;
 }
 
@@ -619,9 +694,9 @@ static bool isDHCPEnabled(uint8_t Channel)
         }
         auto ethIP = ethdevice + "/ipv4";
         auto ethernetObj =
-            getDbusObject(dbus, networkIPIntf, networkRoot, ethIP);
-        auto value = getDbusProperty(dbus, networkService, ethernetObj.first,
-                                     networkIPIntf, "Origin");
+            accounting::getDbusObject(dbus, networkIPIntf, networkRoot, ethIP);
+        auto value = accounting::getDbusProperty(
+            dbus, networkService, ethernetObj.first, networkIPIntf, "Origin");
         if (sdbusplus::message::variant_ns::get<std::string>(value) ==
             "xyz.openbmc_project.Network.IP.AddressOrigin.DHCP")
         {
@@ -655,9 +730,9 @@ static bool isDHCPIPv6Enabled(uint8_t Channel)
         }
         auto ethIP = ethdevice + "/ipv6";
         auto objectInfo =
-            getDbusObject(dbus, networkIPIntf, networkRoot, ethIP);
-        auto properties = getAllDbusProperties(dbus, objectInfo.second,
-                                               objectInfo.first, networkIPIntf);
+            accounting::getDbusObject(dbus, networkIPIntf, networkRoot, ethIP);
+        auto properties = accounting::getAllDbusProperties(
+            dbus, objectInfo.second, objectInfo.first, networkIPIntf);
         if (sdbusplus::message::variant_ns::get<std::string>(
                 properties["Origin"]) ==
             "xyz.openbmc_project.Network.IP.AddressOrigin.DHCP")
@@ -854,9 +929,9 @@ int8_t getLEDState(sdbusplus::bus::bus& bus, const std::string& intf,
 {
     try
     {
-        std::string service = getService(bus, intf, objPath);
+        std::string service = accounting::getService(bus, intf, objPath);
         Value stateValue =
-            getDbusProperty(bus, service, objPath, intf, "State");
+            accounting::getDbusProperty(bus, service, objPath, intf, "State");
         std::string strState =
             sdbusplus::message::variant_ns::get<std::string>(stateValue);
         state = ledAction::actionDbusToIpmi.at(
@@ -1058,7 +1133,7 @@ bool getFanProfileInterface(
     call.append(thermalModeInterface);
     try
     {
-        auto data = bus.call(call);
+        auto data = accounting::call(bus, call);
         data.read(resp);
     }
     catch (sdbusplus::exception_t& e)
@@ -1131,8 +1206,8 @@ ipmi_ret_t ipmiOEMSetFanConfig(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         {
             return IPMI_CC_INVALID_FIELD_REQUEST;
         }
-        setDbusProperty(dbus, settingsBusName, thermalModePath,
-                        thermalModeInterface, "Current", mode);
+        accounting::setDbusProperty(dbus, settingsBusName, thermalModePath,
+                                    thermalModeInterface, "Current", mode);
     }
 
     return IPMI_CC_OK;
@@ -1203,7 +1278,7 @@ static std::string getExitAirConfigPath()
     GetSubTreeType resp;
     try
     {
-        auto reply = dbus.call(method);
+        auto reply = accounting::call(dbus, method);
         reply.read(resp);
     }
     catch (sdbusplus::exception_t&)
@@ -1235,7 +1310,7 @@ static boost::container::flat_map<std::string, PropertyMap> getPidConfigs()
 
     try
     {
-        auto reply = dbus.call(method);
+        auto reply = accounting::call(dbus, method);
         reply.read(resp);
     }
     catch (sdbusplus::exception_t&)
@@ -1249,8 +1324,10 @@ static boost::container::flat_map<std::string, PropertyMap> getPidConfigs()
         {
             continue; // should be impossible
         }
-        ret.emplace(path, getAllDbusProperties(dbus, objects[0].first, path,
-                                               pidConfigurationIface));
+        ret.emplace(path,
+                    accounting::getAllDbusProperties(dbus, objects[0].first,
+                                                     path,
+                                                     pidConfigurationIface));
     }
     return ret;
 }
@@ -1335,9 +1412,10 @@ ipmi::RspType<> ipmiOEMSetFanSpeedOffset(uint8_t offset)
                     "configurations");
                 return ipmi::responseResponseError();
             }
-            ipmi::setDbusProperty(dbus, "xyz.openbmc_project.EntityManager",
-                                  path, pidConfigurationIface, "OutLimitMin",
-                                  static_cast<double>(offset));
+            accounting::setDbusProperty(
+                dbus, "xyz.openbmc_project.EntityManager", path,
+                pidConfigurationIface, "OutLimitMin",
+                static_cast<double>(offset));
             found = true;
         }
     }
@@ -1361,9 +1439,9 @@ ipmi::RspType<> ipmiOEMSetFscParameter(uint8_t command, uint8_t param1,
         if (param1 == legacyExitAirSensorNumber)
         {
             std::string path = getExitAirConfigPath();
-            ipmi::setDbusProperty(dbus, "xyz.openbmc_project.EntityManager",
-                                  path, pidConfigurationIface, "SetPoint",
-                                  static_cast<double>(param2));
+            accounting::setDbusProperty(
+                dbus, "xyz.openbmc_project.EntityManager", path,
+                pidConfigurationIface, "SetPoint", static_cast<double>(param2));
             return ipmi::responseSuccess();
         }
         else
@@ -1383,9 +1461,9 @@ ipmi::RspType<> ipmiOEMSetFscParameter(uint8_t command, uint8_t param1,
 
         try
         {
-            ipmi::setDbusProperty(dbus, settingsBusName, cfmLimitSettingPath,
-                                  cfmLimitIface, "Limit",
-                                  static_cast<double>(cfm));
+            accounting::setDbusProperty(dbus, settingsBusName,
+                                        cfmLimitSettingPath, cfmLimitIface,
+                                        "Limit", static_cast<double>(cfm));
         }
         catch (sdbusplus::exception_t& e)
         {
@@ -1425,7 +1503,7 @@ ipmi::RspType<> ipmiOEMSetFscParameter(uint8_t command, uint8_t param1,
             {
                 if (requestedDomainMask & (1 << count))
                 {
-                    ipmi::setDbusProperty(
+                    accounting::setDbusProperty(
                         dbus, "xyz.openbmc_project.EntityManager", path,
                         pidConfigurationIface, "OutLimitMax",
                         static_cast<double>(param2));
@@ -1466,9 +1544,9 @@ ipmi::RspType<
         std::string path = getExitAirConfigPath();
         if (path.size())
         {
-            Value val =
-                ipmi::getDbusProperty(dbus, "xyz.openbmc_project.EntityManager",
-                                      path, pidConfigurationIface, "SetPoint");
+            Value val = accounting::getDbusProperty(
+                dbus, "xyz.openbmc_project.EntityManager", path,
+                pidConfigurationIface, "SetPoint");
             setpoint = std::floor(std::get<double>(val) + 0.5);
         }
 
@@ -1557,10 +1635,10 @@ ipmi::RspType<
         Value cfmMaximum;
         try
         {
-            cfmLimit = ipmi::getDbusProperty(dbus, settingsBusName,
-                                             cfmLimitSettingPath, cfmLimitIface,
-                                             "Limit");
-            cfmMaximum = ipmi::getDbusProperty(
+            cfmLimit = accounting::getDbusProperty(dbus, settingsBusName,
+                                                   cfmLimitSettingPath,
+                                                   cfmLimitIface, "Limit");
+            cfmMaximum = accounting::getDbusProperty(
                 dbus, "xyz.openbmc_project.ExitAirTempSensor",
                 "/xyz/openbmc_project/control/MaxCFM", cfmLimitIface, "Limit");
         }
@@ -1592,6 +1670,451 @@ ipmi::RspType<
     }
 }
 
+// The settings BIOS reads during POST, served to Get POST Settings from
+// memory. Each source is read once and then kept current from its
+// PropertiesChanged signal. A service that restarts sends no
+// PropertiesChanged, so when one changes owner the snapshot is dropped and
+// read again. GetAll returns
+// every property of an interface, e.g. the Supported list of ThermalMode,
+// so the variant covers those too.
+using PostSettingValue =
+    std::variant<uint8_t, uint16_t, double, std::string, std::vector<uint8_t>,
+                 std::vector<std::string>>;
+
+struct PostSettingSource
+{
+    const char* service; // nullptr when it has to be looked up
+    const char* path;
+    const char* interface;
+};
+
+static const std::array<PostSettingSource, 7> postSettingSources = {{
+    {nullptr, powerRestoreDelayObjPath, powerRestoreDelayIntf},
+    {nullptr, oemShutdownPolicyObjPath, oemShutdownPolicyIntf},
+    {nullptr, processorErrConfigObjPath, processorErrConfigIntf},
+    {settingsBusName, thermalModePath, thermalModeInterface},
+    {settingsBusName, cfmLimitSettingPath, cfmLimitIface},
+    {"xyz.openbmc_project.ExitAirTempSensor",
+     "/xyz/openbmc_project/control/MaxCFM", cfmLimitIface},
+    {nullptr, biosObjPath, biosIntf},
+}};
+
+struct PostSettings
+{
+    std::optional<uint16_t> powerRestoreDelay;
+    std::optional<uint8_t> shutdownPolicy;
+    std::optional<uint8_t> resetCfg;
+    std::optional<std::vector<uint8_t>> caterrStatus;
+    std::optional<std::string> thermalMode;
+    std::optional<double> cfmLimit;
+    std::optional<double> cfmMaximum;
+    std::optional<std::string> biosId;
+};
+static PostSettings postSettings;
+
+// A source that can't be read is marked absent and left alone until its
+// service changes owner or its object is added, so a platform without one
+// of them still answers from memory.
+enum class PostSourceState : uint8_t
+{
+    unread,
+    loaded,
+    absent,
+};
+static std::array<PostSourceState, postSettingSources.size()>
+    postSourceStates{};
+// NameOwnerChanged, one per service a source was read from, by service name
+static boost::container::flat_map<
+    std::string, std::unique_ptr<sdbusplus::bus::match::match>>
+    postSettingOwnerMatches;
+
+template <typename T>
+static void setPostSetting(std::optional<T>& setting,
+                           const PostSettingValue& value)
+{
+    if (const T* typed = std::get_if<T>(&value))
+    {
+        setting = *typed;
+    }
+}
+
+static void updatePostSetting(const std::string& path,
+                              const std::string& interface,
+                              const std::string& property,
+                              const PostSettingValue& value)
+{
+    if (interface == powerRestoreDelayIntf &&
+        property == powerRestoreDelayProp)
+    {
+        setPostSetting(postSettings.powerRestoreDelay, value);
+    }
+    else if (interface == oemShutdownPolicyIntf &&
+             property == oemShutdownPolicyObjPathProp)
+    {
+        setPostSetting(postSettings.shutdownPolicy, value);
+    }
+    else if (interface == processorErrConfigIntf && property == "ResetCfg")
+    {
+        setPostSetting(postSettings.resetCfg, value);
+    }
+    else if (interface == processorErrConfigIntf &&
+             property == "CATERRStatus")
+    {
+        setPostSetting(postSettings.caterrStatus, value);
+    }
+    else if (interface == thermalModeInterface && property == "Current")
+    {
+        setPostSetting(postSettings.thermalMode, value);
+    }
+    else if (interface == cfmLimitIface && property == "Limit")
+    {
+        setPostSetting(path == cfmLimitSettingPath ? postSettings.cfmLimit
+                                                   : postSettings.cfmMaximum,
+                       value);
+    }
+    else if (interface == biosIntf && property == biosProp)
+    {
+        setPostSetting(postSettings.biosId, value);
+    }
+}
+
+static void postSettingChanged(sdbusplus::message::message& m)
+{
+    std::string interface;
+    boost::container::flat_map<std::string, PostSettingValue> properties;
+    try
+    {
+        m.read(interface, properties);
+    }
+    catch (sdbusplus::exception_t&)
+    {
+        return;
+    }
+    for (const auto& [property, value] : properties)
+    {
+        updatePostSetting(m.get_path(), interface, property, value);
+    }
+    ipmi::cache::refresh(ipmi::cache::CacheId::settings);
+}
+
+// a restarted service sends no PropertiesChanged, so the next request reads
+// every source again, by then the service has had time to put its objects
+// back
+static void postSettingOwnerChanged(sdbusplus::message::message&)
+{
+    postSettings = PostSettings();
+    postSourceStates.fill(PostSourceState::unread);
+    ipmi::cache::invalidate(ipmi::cache::CacheId::settings);
+}
+
+static void watchPostSettingService(const std::string& service)
+{
+    if (postSettingOwnerMatches.find(service) != postSettingOwnerMatches.end())
+    {
+        return;
+    }
+    postSettingOwnerMatches.emplace(
+        service, std::make_unique<sdbusplus::bus::match::match>(
+                     dbus,
+                     "type='signal',sender='org.freedesktop.DBus',interface="
+                     "'org.freedesktop.DBus',member='NameOwnerChanged',arg0='" +
+                         service + "'",
+                     postSettingOwnerChanged));
+}
+
+static bool loadPostSettings(const PostSettingSource& source)
+{
+    try
+    {
+        std::string service = source.service
+                                  ? source.service
+                                  : accounting::getService(
+                                        dbus, source.interface, source.path);
+        watchPostSettingService(service);
+        auto getAll = dbus.new_method_call(service.c_str(), source.path,
+                                           PROP_INTF, "GetAll");
+        getAll.append(source.interface);
+        auto reply = accounting::call(dbus, getAll);
+        boost::container::flat_map<std::string, PostSettingValue> properties;
+        reply.read(properties);
+        for (const auto& [property, value] : properties)
+        {
+            updatePostSetting(source.path, source.interface, property, value);
+        }
+    }
+    catch (sdbusplus::exception_t& e)
+    {
+        static ipmi::ratelog::Site site("loadPostSettings");
+        ipmi::ratelog::log<phosphor::logging::level::ERR>(
+            site, "Failed to read POST settings",
+            ipmi::ratelog::entry("PATH=%s", source.path),
+            ipmi::ratelog::entry("ERR=%s", e.what()));
+        return false;
+    }
+    return true;
+}
+
+static const PostSettings& getPostSettings()
+{
+    static std::vector<sdbusplus::bus::match::match> matches;
+    if (matches.empty())
+    {
+        // subscribed before the first read so no change can slip between
+        matches.reserve(postSettingSources.size() * 2);
+        for (size_t ii = 0; ii < postSettingSources.size(); ii++)
+        {
+            const PostSettingSource& source = postSettingSources[ii];
+            matches.emplace_back(
+                dbus,
+                "type='signal',member='PropertiesChanged',interface='org."
+                "freedesktop.DBus.Properties',path='" +
+                    std::string(source.path) + "',arg0='" + source.interface +
+                    "'",
+                postSettingChanged);
+            // an absent source is read again once its object shows up
+            matches.emplace_back(
+                dbus,
+                "type='signal',member='InterfacesAdded',interface='org."
+                "freedesktop.DBus.ObjectManager',arg0path='" +
+                    std::string(source.path) + "'",
+                [ii](sdbusplus::message::message&) {
+                    if (postSourceStates[ii] == PostSourceState::absent)
+                    {
+                        postSourceStates[ii] = PostSourceState::unread;
+                    }
+                });
+            if (source.service != nullptr)
+            {
+                watchPostSettingService(source.service);
+            }
+        }
+    }
+
+    bool loaded = true;
+    for (size_t ii = 0; ii < postSourceStates.size(); ii++)
+    {
+        if (postSourceStates[ii] != PostSourceState::unread)
+        {
+            continue;
+        }
+        if (loaded)
+        {
+            ipmi::cache::miss(ipmi::cache::CacheId::settings);
+            loaded = false;
+        }
+        if (loadPostSettings(postSettingSources[ii]))
+        {
+            postSourceStates[ii] = PostSourceState::loaded;
+            ipmi::cache::refresh(ipmi::cache::CacheId::settings);
+        }
+        else
+        {
+            postSourceStates[ii] = PostSourceState::absent;
+        }
+    }
+    if (loaded)
+    {
+        ipmi::cache::hit(ipmi::cache::CacheId::settings);
+    }
+    return postSettings;
+}
+
+static std::optional<std::vector<uint8_t>> getCaterrStatusSnapshot()
+{
+    // not loaded from here, that would read every source; once Get POST
+    // Settings has loaded it, the matches keep it current
+    return postSettings.caterrStatus;
+}
+
+// settings set but still waiting in the write-behind queue win over the
+// snapshot
+template <typename T>
+static void overlayQueuedWrite(std::optional<T>& setting, const char* path,
+                               const char* interface, const char* property)
+{
+    std::optional<Value> queued =
+        writebehind::pending(path, interface, property);
+    if (queued)
+    {
+        if (const T* typed = std::get_if<T>(&*queued))
+        {
+            setting = *typed;
+        }
+    }
+}
+
+/** @brief implements the get POST settings command
+ *  Returns in one response what BIOS otherwise reads with Get Power Restore
+ *  Delay, Get Shutdown Policy, Get Processor Error Config, Get Fan Config,
+ *  the CFM parameters of Get FSC Parameter and the BIOS ID of Get OEM
+ *  Device Info.
+ *
+ *  @returns IPMI completion code plus response data
+ *   - PostSettingsRecord, fields without their valid bit set are zero
+ *   - the first maxPostBiosIdLength bytes of the BIOS ID
+ */
+ipmi::RspType<std::vector<uint8_t> // record and BIOS ID
+              >
+    ipmiOEMGetPostSettings()
+{
+    PostSettings settings = getPostSettings();
+    overlayQueuedWrite(settings.powerRestoreDelay, powerRestoreDelayObjPath,
+                       powerRestoreDelayIntf, powerRestoreDelayProp);
+    overlayQueuedWrite(settings.shutdownPolicy, oemShutdownPolicyObjPath,
+                       oemShutdownPolicyIntf, oemShutdownPolicyObjPathProp);
+    overlayQueuedWrite(settings.resetCfg, processorErrConfigObjPath,
+                       processorErrConfigIntf, "ResetCfg");
+    overlayQueuedWrite(settings.biosId, biosObjPath, biosIntf, biosProp);
+
+    PostSettingsRecord record = {0};
+    if (settings.powerRestoreDelay)
+    {
+        record.valid |=
+            static_cast<uint8_t>(PostSettingsValid::powerRestoreDelay);
+        record.powerRestoreDelay = *settings.powerRestoreDelay;
+    }
+    if (settings.shutdownPolicy)
+    {
+        record.valid |= static_cast<uint8_t>(PostSettingsValid::shutdownPolicy);
+        record.shutdownPolicy = *settings.shutdownPolicy;
+        // TODO needs to check if it is multi-node products,
+        // policy is only supported on node 3/4
+        record.shutdownPolicySupport = shutdownPolicySupported;
+    }
+    if (settings.resetCfg)
+    {
+        record.valid |=
+            static_cast<uint8_t>(PostSettingsValid::processorErrConfig);
+        record.resetCfg = *settings.resetCfg;
+    }
+    if (settings.caterrStatus)
+    {
+        record.valid |= static_cast<uint8_t>(PostSettingsValid::caterrStatus);
+        std::copy_n(settings.caterrStatus->begin(),
+                    std::min<size_t>(maxCPUNum, settings.caterrStatus->size()),
+                    record.caterrStatus);
+    }
+    if (settings.thermalMode)
+    {
+        record.valid |= static_cast<uint8_t>(PostSettingsValid::fanProfile);
+        if (*settings.thermalMode == "Performance")
+        {
+            record.fanProfileFlags |= 1 << 2;
+        }
+    }
+    if (settings.cfmLimit && settings.cfmMaximum)
+    {
+        record.valid |= static_cast<uint8_t>(PostSettingsValid::cfm);
+        record.cfmLimit =
+            static_cast<uint16_t>(std::floor(*settings.cfmLimit + 0.5));
+        record.cfmMaximum =
+            static_cast<uint16_t>(std::floor(*settings.cfmMaximum + 0.5));
+    }
+    size_t biosIdLength = 0;
+    if (settings.biosId)
+    {
+        record.valid |= static_cast<uint8_t>(PostSettingsValid::biosId);
+        record.biosIdLength =
+            std::min<size_t>(settings.biosId->size(), maxBIOSIDLength);
+        biosIdLength =
+            std::min<size_t>(record.biosIdLength, maxPostBiosIdLength);
+    }
+
+    const uint8_t* raw = reinterpret_cast<const uint8_t*>(&record);
+    std::vector<uint8_t> data(raw, raw + sizeof(record));
+    if (biosIdLength)
+    {
+        data.insert(data.end(), settings.biosId->begin(),
+                    settings.biosId->begin() + biosIdLength);
+    }
+    return ipmi::responseSuccess(data);
+}
+
+/** @brief implements the get flight recorder command
+ *  Returns recent requests newest first, starting offset entries back from
+ *  the newest one.
+ *  @param offset - number of entries to skip
+ *  @param count - number of entries to return, defaults to as many as fit
+ *
+ *  @returns IPMI completion code plus response data
+ *   - number of entries held by the recorder
+ *   - number of entries returned
+ *   - packed FlightRecorderEntry records
+ */
+ipmi::RspType<uint16_t,            // entries held
+              uint8_t,             // entries returned
+              std::vector<uint8_t> // entries
+              >
+    ipmiOEMGetFlightRecorder(uint16_t offset, std::optional<uint8_t> count)
+{
+    uint8_t maxEntries = count.value_or(maxFlightRecorderEntries);
+    if (maxEntries > maxFlightRecorderEntries)
+    {
+        return ipmi::responseInvalidFieldRequest();
+    }
+
+    std::vector<ipmi::flight::Entry> entries = ipmi::flight::snapshot();
+    std::vector<uint8_t> data;
+    uint8_t returned = 0;
+    size_t skip = std::min<size_t>(offset, entries.size());
+    for (auto entry = entries.rbegin() + skip;
+         entry != entries.rend() && returned < maxEntries; entry++, returned++)
+    {
+        FlightRecorderEntry packed;
+        packed.timestampUs = entry->timestampUs;
+        packed.latencyUs = entry->latencyUs;
+        packed.requestLength = entry->requestLength;
+        packed.responseLength = entry->responseLength;
+        packed.dbusCalls = entry->dbusCalls;
+        packed.channel = entry->channel;
+        packed.netfn = entry->netfn;
+        packed.cmd = entry->cmd;
+        packed.cc = entry->cc;
+        const uint8_t* raw = reinterpret_cast<const uint8_t*>(&packed);
+        data.insert(data.end(), raw, raw + sizeof(packed));
+    }
+
+    return ipmi::responseSuccess(static_cast<uint16_t>(entries.size()),
+                                 returned, data);
+}
+
+/** @brief implements the get cache statistics command
+ *  @param reset - when bit 0 is set the counters are cleared after being read
+ *
+ *  @returns IPMI completion code plus response data
+ *   - number of caches reported
+ *   - packed CacheStatsRecord per cache (sensors, SDR, FRU, SEL, settings)
+ */
+ipmi::RspType<uint8_t,             // cache count
+              std::vector<uint8_t> // records
+              >
+    ipmiOEMGetCacheStats(std::optional<uint8_t> reset)
+{
+    std::vector<uint8_t> data;
+    for (size_t id = 0; id < ipmi::cache::cacheCount; id++)
+    {
+        ipmi::cache::CacheCounters counters =
+            ipmi::cache::getCounters(static_cast<ipmi::cache::CacheId>(id));
+        CacheStatsRecord record;
+        record.cacheId = static_cast<uint8_t>(id);
+        record.hits = counters.hits;
+        record.misses = counters.misses;
+        record.refreshes = counters.refreshes;
+        record.invalidations = counters.invalidations;
+        record.generation = counters.generation;
+        const uint8_t* raw = reinterpret_cast<const uint8_t*>(&record);
+        data.insert(data.end(), raw, raw + sizeof(record));
+    }
+
+    if (reset.value_or(0) & 0x1)
+    {
+        ipmi::cache::resetCounters();
+    }
+
+    return ipmi::responseSuccess(
+        static_cast<uint8_t>(ipmi::cache::cacheCount), data);
+}
+
 static void registerOEMFunctions(void)
 {
     phosphor::logging::log<phosphor::logging::level::INFO>(
@@ -1627,7 +2150,7 @@ static void registerOEMFunctions(void)
             IPMINetfnIntelOEMGeneralCmd::cmdGetAICSlotFRUIDSlotPosRecords),
         NULL, ipmiOEMGetAICFRU, PRIVILEGE_USER);
 
-    ipmi::registerHandler(
+    ipmi::registerTimedHandler(
         ipmi::prioOpenBmcBase, ipmi::netFnOemOne,
         static_cast<ipmi::Cmd>(
             IPMINetfnIntelOEMGeneralCmd::cmdSendEmbeddedFWUpdStatus),
@@ -1644,13 +2167,13 @@ static void registerOEMFunctions(void)
             IPMINetfnIntelOEMGeneralCmd::cmdGetPowerRestoreDelay),
         NULL, ipmiOEMGetPowerRestoreDelay, PRIVILEGE_USER);
 
-    ipmi::registerHandler(
+    ipmi::registerTimedHandler(
         ipmi::prioOpenBmcBase, ipmi::netFnOemOne,
         static_cast<ipmi::Cmd>(
             IPMINetfnIntelOEMGeneralCmd::cmdSetOEMUser2Activation),
         ipmi::Privilege::Callback, ipmiOEMSetUser2Activation);
 
-    ipmi::registerHandler(
+    ipmi::registerTimedHandler(
         ipmi::prioOpenBmcBase, ipmi::netFnOemOne,
         static_cast<ipmi::Cmd>(
             IPMINetfnIntelOEMGeneralCmd::cmdSetSpecialUserPassword),
@@ -1685,24 +2208,24 @@ static void registerOEMFunctions(void)
         static_cast<ipmi_cmd_t>(IPMINetfnIntelOEMGeneralCmd::cmdGetFanConfig),
         NULL, ipmiOEMGetFanConfig, PRIVILEGE_USER);
 
-    ipmi::registerHandler(
+    ipmi::registerTimedHandler(
         ipmi::prioOemBase, netfnIntcOEMGeneral,
         static_cast<ipmi::Cmd>(
             IPMINetfnIntelOEMGeneralCmd::cmdGetFanSpeedOffset),
         ipmi::Privilege::User, ipmiOEMGetFanSpeedOffset);
 
-    ipmi::registerHandler(
+    ipmi::registerTimedHandler(
         ipmi::prioOemBase, netfnIntcOEMGeneral,
         static_cast<ipmi::Cmd>(
             IPMINetfnIntelOEMGeneralCmd::cmdSetFanSpeedOffset),
         ipmi::Privilege::User, ipmiOEMSetFanSpeedOffset);
 
-    ipmi::registerHandler(
+    ipmi::registerTimedHandler(
         ipmi::prioOemBase, netfnIntcOEMGeneral,
         static_cast<ipmi::Cmd>(IPMINetfnIntelOEMGeneralCmd::cmdSetFscParameter),
         ipmi::Privilege::User, ipmiOEMSetFscParameter);
 
-    ipmi::registerHandler(
+    ipmi::registerTimedHandler(
         ipmi::prioOemBase, netfnIntcOEMGeneral,
         static_cast<ipmi::Cmd>(IPMINetfnIntelOEMGeneralCmd::cmdGetFscParameter),
         ipmi::Privilege::User, ipmiOEMGetFscParameter);
@@ -1716,6 +2239,22 @@ static void registerOEMFunctions(void)
         static_cast<ipmi_cmd_t>(
             IPMINetfnIntelOEMPlatformCmd::cmdCfgHostSerialPortSpeed),
         NULL, ipmiOEMCfgHostSerialPortSpeed, PRIVILEGE_ADMIN);
+
+    ipmi::registerTimedHandler(
+        ipmi::prioOemBase, netfnIntcOEMGeneral,
+        static_cast<ipmi::Cmd>(
+            IPMINetfnIntelOEMGeneralCmd::cmdGetFlightRecorder),
+        ipmi::Privilege::Admin, ipmiOEMGetFlightRecorder);
+
+    ipmi::registerTimedHandler(
+        ipmi::prioOemBase, netfnIntcOEMGeneral,
+        static_cast<ipmi::Cmd>(IPMINetfnIntelOEMGeneralCmd::cmdGetCacheStats),
+        ipmi::Privilege::Admin, ipmiOEMGetCacheStats);
+
+    ipmi::registerTimedHandler(
+        ipmi::prioOemBase, netfnIntcOEMGeneral,
+        static_cast<ipmi::Cmd>(IPMINetfnIntelOEMGeneralCmd::cmdGetPostSettings),
+        ipmi::Privilege::User, ipmiOEMGetPostSettings);
     return;
 }
 
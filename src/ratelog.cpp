@@ -0,0 +1,123 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <sys/uio.h>
+#include <systemd/sd-journal.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <ratelog.hpp>
+#include <thread>
+
+namespace ipmi
+{
+namespace ratelog
+{
+// records waiting beyond this are dropped and counted on the next one
+static constexpr const size_t maxQueued = 256;
+
+class Writer
+{
+  public:
+    ~Writer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        ready.notify_one();
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+
+    void push(Record&& record)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (queue.size() >= maxQueued)
+            {
+                dropped++;
+                return;
+            }
+            if (dropped)
+            {
+                record.fields.emplace_back("DROPPED=" +
+                                           std::to_string(dropped));
+                dropped = 0;
+            }
+            queue.emplace_back(std::move(record));
+            // started on first use, so providers that never log don't
+            // carry an idle thread
+            if (!thread.joinable())
+            {
+                thread = std::thread([this] { run(); });
+            }
+        }
+        ready.notify_one();
+    }
+
+  private:
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            ready.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty())
+            {
+                return;
+            }
+            Record record = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            send(record);
+            lock.lock();
+        }
+    }
+
+    static void send(const Record& record)
+    {
+        std::string message = "MESSAGE=" + record.message;
+        std::string priority = "PRIORITY=" + std::to_string(record.priority);
+        std::vector<iovec> iov;
+        iov.reserve(record.fields.size() + 2);
+        iov.push_back({message.data(), message.size()});
+        iov.push_back({priority.data(), priority.size()});
+        for (const std::string& field : record.fields)
+        {
+            iov.push_back({const_cast<char*>(field.data()), field.size()});
+        }
+        sd_journal_sendv(iov.data(), iov.size());
+    }
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<Record> queue;
+    size_t dropped = 0;
+    bool stopping = false;
+    std::thread thread;
+};
+
+void submit(Record&& record)
+{
+    static Writer writer;
+    writer.push(std::move(record));
+}
+} // namespace ratelog
+} // namespace ipmi
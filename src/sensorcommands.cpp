@@ -14,31 +14,41 @@
 // limitations under the License.
 */
 
+#include <algorithm>
+#include <array>
 #include <boost/algorithm/string.hpp>
 #include <boost/container/flat_map.hpp>
+#include <cachestats.hpp>
+#include <cctype>
 #include <chrono>
 #include <cmath>
 #include <commandutils.hpp>
+#include <cstring>
+#include <dbuspipeline.hpp>
+#include <fruutils.hpp>
+#include <intern.hpp>
 #include <iostream>
 #include <ipmid/api.hpp>
 #include <ipmid/utils.hpp>
+#include <limits>
+#include <memory>
+#include <oemcommands.hpp>
 #include <phosphor-logging/log.hpp>
+#include <ratelog.hpp>
 #include <sdbusplus/bus.hpp>
 #include <sdrutils.hpp>
 #include <sensorcommands.hpp>
+#include <sensorobjects.hpp>
+#include <sensorsdr.hpp>
 #include <sensorutils.hpp>
 #include <storagecommands.hpp>
 #include <string>
+#include <string_view>
+#include <tracepoints.hpp>
+#include <unordered_map>
 
 namespace ipmi
 {
-using ManagedObjectType =
-    std::map<sdbusplus::message::object_path,
-             std::map<std::string, std::map<std::string, DbusVariant>>>;
-
-using SensorMap = std::map<std::string, std::map<std::string, DbusVariant>>;
-namespace variant_ns = sdbusplus::message::variant_ns;
-
 static constexpr int sensorListUpdatePeriod = 10;
 static constexpr int sensorMapUpdatePeriod = 2;
 
@@ -51,22 +61,31 @@ static uint32_t sdrLastAdd = noTimestamp;
 static uint32_t sdrLastRemove = noTimestamp;
 
 SensorSubTree sensorTree;
-static boost::container::flat_map<std::string, ManagedObjectType> SensorCache;
-
-// Specify the comparison required to sort and find char* map objects
-struct CmpStr
+// each connection's sensors live in their own arena, dropped and refilled
+// on refresh, and are looked up by interned path
+struct SensorCacheEntry
 {
-    bool operator()(const char *a, const char *b) const
-    {
-        return std::strcmp(a, b) < 0;
-    }
+    arena::RefreshArena arena;
+    arena::ObjectMap objects{arena.resource()};
+    boost::container::flat_map<intern::Id, const arena::InterfaceMap *>
+        byPath;
+    // when objects were read from the connection
+    std::chrono::steady_clock::time_point sampled;
+};
+// keyed by interned connection name
+static boost::container::flat_map<intern::Id,
+                                  std::unique_ptr<SensorCacheEntry>>
+    SensorCache;
+
+// Sensor name and path to record id, so hosts can find a sensor without
+// reading every SDR. Rebuilt from sensorTree after it changes; the record
+// id is the sensor's index in sensorTree, as in Get SDR.
+struct SensorNameIndex
+{
+    std::unordered_map<std::string, uint16_t> byName;
+    std::unordered_map<intern::Id, uint16_t> byPath;
 };
-const static boost::container::flat_map<const char *, SensorUnits, CmpStr>
-    sensorUnits{{{"temperature", SensorUnits::degreesC},
-                 {"voltage", SensorUnits::volts},
-                 {"current", SensorUnits::amps},
-                 {"fan_tach", SensorUnits::rpm},
-                 {"power", SensorUnits::watts}}};
+static SensorNameIndex sensorNameIndex;
 
 void registerSensorFunctions() __attribute__((constructor));
 static sdbusplus::bus::bus dbus(ipmid_get_sd_bus_connection());
@@ -77,6 +96,8 @@ static sdbusplus::bus::match::match sensorAdded(
     "sensors/'",
     [](sdbusplus::message::message &m) {
         sensorTree.clear();
+        sensorNameIndex.byName.clear();
+        sensorNameIndex.byPath.clear();
         sdrLastAdd = std::chrono::duration_cast<std::chrono::seconds>(
                          std::chrono::system_clock::now().time_since_epoch())
                          .count();
@@ -88,15 +109,184 @@ static sdbusplus::bus::match::match sensorRemoved(
     "sensors/'",
     [](sdbusplus::message::message &m) {
         sensorTree.clear();
+        sensorNameIndex.byName.clear();
+        sensorNameIndex.byPath.clear();
         sdrLastRemove = std::chrono::duration_cast<std::chrono::seconds>(
                             std::chrono::system_clock::now().time_since_epoch())
                             .count();
     });
 
+// scanning and event enables set by the host with Set Sensor Event Enable,
+// keyed by interned sensor path. Sensors that were never set are enabled.
+// Masks hold the assertion/deassertion events the host disabled, so a
+// sensor gaining thresholds later reports them enabled by default.
+struct SensorEventEnable
+{
+    bool scanning = true;
+    bool events = true;
+    uint16_t assertionsDisabled = 0;
+    uint16_t deassertionsDisabled = 0;
+};
+static boost::container::flat_map<intern::Id, SensorEventEnable>
+    sensorEventEnables;
+
+static const SensorEventEnable &getSensorEventEnable(intern::Id pathId)
+{
+    static const SensorEventEnable enabled;
+    auto find = sensorEventEnables.find(pathId);
+    if (find == sensorEventEnables.end())
+    {
+        return enabled;
+    }
+    return find->second;
+}
+
+static uint8_t sensorEventEnableByte(const SensorEventEnable &enable)
+{
+    uint8_t byte = 0;
+    if (enable.events)
+    {
+        byte |= static_cast<uint8_t>(
+            IPMISensorEventEnableByte2::eventMessagesEnable);
+    }
+    if (enable.scanning)
+    {
+        byte |= static_cast<uint8_t>(
+            IPMISensorEventEnableByte2::sensorScanningEnable);
+    }
+    return byte;
+}
+
+#ifdef IPMI_THRESHOLD_SEL
+static void logThresholdEvent(const std::string &path,
+                              const std::string &alarm, bool assert);
+#endif
+
+// Sensors on the host's power rails (CPU, DIMM, VR and PCH) read nothing
+// useful while the host is off. Their connections aren't refreshed and their
+// readings are unavailable until it powers on; the first read after power
+// on refreshes whatever was cached while it was off.
+static constexpr const char *hostStateService =
+    "xyz.openbmc_project.State.Host";
+static constexpr const char *hostStatePath =
+    "/xyz/openbmc_project/state/host0";
+static constexpr const char *hostStateInterface =
+    "xyz.openbmc_project.State.Host";
+
+static std::optional<bool> hostPoweredOn;
+static std::chrono::steady_clock::time_point hostPowerOnTime;
+
+static void setHostState(const std::string &state)
+{
+    bool on = !boost::ends_with(state, ".Off");
+    if (on && hostPoweredOn && !*hostPoweredOn)
+    {
+        hostPowerOnTime = std::chrono::steady_clock::now();
+    }
+    hostPoweredOn = on;
+}
+
+static sdbusplus::bus::match::match hostStateChanged(
+    dbus,
+    "type='signal',member='PropertiesChanged',interface='org.freedesktop.DBus."
+    "Properties',path='/xyz/openbmc_project/state/host0',arg0='xyz."
+    "openbmc_project.State.Host'",
+    [](sdbusplus::message::message &m) {
+        boost::container::flat_map<std::string, std::variant<std::string>>
+            values;
+        m.read(std::string(), values);
+        auto state = values.find("CurrentHostState");
+        if (state != values.end())
+        {
+            setHostState(std::get<std::string>(state->second));
+        }
+    });
+
+// set when the host state object doesn't exist, so platforms without one
+// don't pay a failed D-Bus call on every gated read; cleared when the
+// service or object shows up
+static bool hostStateAbsent = false;
+
+static void hostStateAppeared(sdbusplus::message::message &)
+{
+    hostStateAbsent = false;
+}
+
+static sdbusplus::bus::match::match hostStateOwnerChanged(
+    dbus,
+    "type='signal',sender='org.freedesktop.DBus',interface='org.freedesktop."
+    "DBus',member='NameOwnerChanged',arg0='xyz.openbmc_project.State.Host'",
+    hostStateAppeared);
+
+static sdbusplus::bus::match::match hostStateAdded(
+    dbus,
+    "type='signal',interface='org.freedesktop.DBus.ObjectManager',member='"
+    "InterfacesAdded',arg0path='/xyz/openbmc_project/state/host0'",
+    hostStateAppeared);
+
+static bool isMissingObjectError(const sdbusplus::exception_t &e)
+{
+    static constexpr std::array<std::string_view, 3> missing = {
+        "org.freedesktop.DBus.Error.ServiceUnknown",
+        "org.freedesktop.DBus.Error.UnknownObject",
+        "org.freedesktop.DBus.Error.UnknownInterface"};
+    const char *name = e.name();
+    return name != nullptr &&
+           std::find(missing.begin(), missing.end(), name) != missing.end();
+}
+
+static void logHostStateUnknown(const char *what)
+{
+    static ipmi::ratelog::Site site("isHostOn");
+    ipmi::ratelog::log<phosphor::logging::level::INFO>(
+        site, "Host state unknown, refreshing all sensors",
+        ipmi::ratelog::entry("WHAT=%s", what));
+}
+
+// treated as on until a read succeeds. A missing service or object is
+// remembered until one of the matches above sees it appear, any other error
+// is retried by the next call
+static bool isHostOn()
+{
+    if (!hostPoweredOn)
+    {
+        if (hostStateAbsent)
+        {
+            return true;
+        }
+        try
+        {
+            Value state = accounting::getDbusProperty(
+                dbus, hostStateService, hostStatePath, hostStateInterface,
+                "CurrentHostState");
+            setHostState(std::get<std::string>(state));
+        }
+        catch (sdbusplus::exception_t& e)
+        {
+            hostStateAbsent = isMissingObjectError(e);
+            logHostStateUnknown(e.what());
+            return true;
+        }
+        catch (std::exception& e)
+        {
+            logHostStateUnknown(e.what());
+            return true;
+        }
+    }
+    return *hostPoweredOn;
+}
+
+static bool isPoweredOff(intern::Id pathId, std::string_view path)
+{
+    static PowerGateCache powerGated;
+    return powerGated.isGated(pathId, path) && !isHostOn();
+}
+
 // this keeps track of deassertions for sensor event status command. A
 // deasertion can only happen if an assertion was seen first.
+// Keyed by interned sensor path and alarm property name.
 static boost::container::flat_map<
-    std::string, boost::container::flat_map<std::string, std::optional<bool>>>
+    intern::Id, boost::container::flat_map<intern::Id, std::optional<bool>>>
     thresholdDeassertMap;
 
 static sdbusplus::bus::match::match thresholdChanged(
@@ -121,55 +311,85 @@ static sdbusplus::bus::match::match thresholdChanged(
                     "thresholdChanged: Assert non bool");
                 return;
             }
+            intern::Id pathId = intern::paths().intern(m.get_path());
+            const SensorEventEnable &enable = getSensorEventEnable(pathId);
+            // disabling event messages only stops the SEL entries, the alarm
+            // state is still tracked for Get Sensor Event Status
+            if (!enable.scanning)
+            {
+                return;
+            }
+            intern::Id alarmId = intern::names().intern(findAssert->first);
             if (*ptr)
             {
                 phosphor::logging::log<phosphor::logging::level::INFO>(
                     "thresholdChanged: Assert",
                     phosphor::logging::entry("SENSOR=%s", m.get_path()));
-                thresholdDeassertMap[m.get_path()][findAssert->first] = *ptr;
+                thresholdDeassertMap[pathId][alarmId] = *ptr;
+#ifdef IPMI_THRESHOLD_SEL
+                if (enable.events)
+                {
+                    logThresholdEvent(m.get_path(), findAssert->first, *ptr);
+                }
+#endif
             }
             else
             {
-                auto &value =
-                    thresholdDeassertMap[m.get_path()][findAssert->first];
+                auto &value = thresholdDeassertMap[pathId][alarmId];
                 if (value)
                 {
                     phosphor::logging::log<phosphor::logging::level::INFO>(
                         "thresholdChanged: deassert",
                         phosphor::logging::entry("SENSOR=%s", m.get_path()));
                     value = *ptr;
+#ifdef IPMI_THRESHOLD_SEL
+                    if (enable.events)
+                    {
+                        logThresholdEvent(m.get_path(), findAssert->first,
+                                          *ptr);
+                    }
+#endif
                 }
             }
         }
     });
 
-static void
-    getSensorMaxMin(const std::map<std::string, DbusVariant> &sensorPropertyMap,
-                    double &max, double &min)
+// sensor values as last read from D-Bus, without reading them again
+static bool
+    findCachedSensor(intern::Id connectionId, intern::Id pathId,
+                     SensorMap &sensorMap,
+                     std::chrono::steady_clock::time_point *sampled = nullptr)
 {
-    auto maxMap = sensorPropertyMap.find("MaxValue");
-    auto minMap = sensorPropertyMap.find("MinValue");
-    max = 127;
-    min = -128;
-
-    if (maxMap != sensorPropertyMap.end())
+    auto connection = SensorCache.find(connectionId);
+    if (connection == SensorCache.end())
     {
-        max = variant_ns::visit(VariantToDoubleVisitor(), maxMap->second);
+        return false;
     }
-    if (minMap != sensorPropertyMap.end())
+    const auto &byPath = connection->second->byPath;
+    auto path = byPath.find(pathId);
+    if (path == byPath.end())
     {
-        min = variant_ns::visit(VariantToDoubleVisitor(), minMap->second);
+        return false;
     }
+    toSensorMap(*path->second, sensorMap);
+    if (sampled != nullptr)
+    {
+        *sampled = connection->second->sampled;
+    }
+    return true;
 }
 
-static bool getSensorMap(std::string sensorConnection, std::string sensorPath,
-                         SensorMap &sensorMap)
+// sampled, if given, is set to when the values were read from D-Bus
+static bool getSensorMap(
+    std::string sensorConnection, std::string sensorPath, SensorMap &sensorMap,
+    std::chrono::steady_clock::time_point *sampled = nullptr)
 {
     static boost::container::flat_map<
-        std::string, std::chrono::time_point<std::chrono::steady_clock>>
+        intern::Id, std::chrono::time_point<std::chrono::steady_clock>>
         updateTimeMap;
 
-    auto updateFind = updateTimeMap.find(sensorConnection);
+    intern::Id connectionId = intern::names().intern(sensorConnection);
+    auto updateFind = updateTimeMap.find(connectionId);
     auto lastUpdate = std::chrono::time_point<std::chrono::steady_clock>();
     if (updateFind != updateTimeMap.end())
     {
@@ -178,44 +398,301 @@ static bool getSensorMap(std::string sensorConnection, std::string sensorPath,
 
     auto now = std::chrono::steady_clock::now();
 
-    if (std::chrono::duration_cast<std::chrono::seconds>(now - lastUpdate)
-            .count() > sensorMapUpdatePeriod)
-    {
-        updateTimeMap[sensorConnection] = now;
+    // a sensor the host stopped scanning, or that is powered off, doesn't
+    // pull its connection from D-Bus again, whatever was last read is good
+    // enough
+    intern::Id pathId = intern::paths().intern(sensorPath);
+    bool skipRefresh =
+        (!getSensorEventEnable(pathId).scanning ||
+         isPoweredOff(pathId, sensorPath)) &&
+        SensorCache.find(connectionId) != SensorCache.end();
+    bool expired =
+        std::chrono::duration_cast<std::chrono::seconds>(now - lastUpdate)
+            .count() > sensorMapUpdatePeriod;
+    // read while the host was off, don't wait out the period
+    bool stale = lastUpdate < hostPowerOnTime;
+
+    if (!skipRefresh && (expired || stale))
+    {
+        IPMI_PROBE2(sensor_cache_miss, sensorConnection.c_str(),
+                    sensorPath.c_str());
+        cache::miss(cache::CacheId::sensors);
+        updateTimeMap[connectionId] = now;
 
         auto managedObj = dbus.new_method_call(
             sensorConnection.c_str(), "/", "org.freedesktop.DBus.ObjectManager",
             "GetManagedObjects");
 
-        ManagedObjectType managedObjects;
+        sdbusplus::message::message reply;
         try
         {
-            auto reply = dbus.call(managedObj);
-            reply.read(managedObjects);
+            reply = accounting::call(dbus, managedObj);
         }
         catch (sdbusplus::exception_t &)
         {
-            phosphor::logging::log<phosphor::logging::level::ERR>(
-                "Error getting managed objects from connection",
-                phosphor::logging::entry("CONNECTION=%s",
-                                         sensorConnection.c_str()));
+            static ipmi::ratelog::Site site("getSensorMap.fetch");
+            ipmi::ratelog::log<phosphor::logging::level::ERR>(
+                site, "Error getting managed objects from connection",
+                ipmi::ratelog::entry("CONNECTION=%s",
+                                     sensorConnection.c_str()));
             return false;
         }
 
-        SensorCache[sensorConnection] = managedObjects;
+        std::unique_ptr<SensorCacheEntry> &entry = SensorCache[connectionId];
+        if (!entry)
+        {
+            entry = std::make_unique<SensorCacheEntry>();
+        }
+        entry->byPath.clear();
+        entry->objects.clear();
+        entry->arena.reset();
+        int r = readSensorObjects(reply.get(), entry->arena, entry->objects);
+        if (r < 0)
+        {
+            entry->objects.clear();
+            static ipmi::ratelog::Site site("getSensorMap.decode");
+            ipmi::ratelog::log<phosphor::logging::level::ERR>(
+                site, "Error decoding managed objects from connection",
+                ipmi::ratelog::entry("CONNECTION=%s",
+                                     sensorConnection.c_str()),
+                ipmi::ratelog::entry("ERRNO=%d", -r));
+            return false;
+        }
+        entry->byPath.reserve(entry->objects.size());
+        for (const auto &[objectPath, interfaces] : entry->objects)
+        {
+            entry->byPath.emplace(intern::paths().intern(objectPath),
+                                  &interfaces);
+        }
+        entry->sampled = now;
+        cache::refresh(cache::CacheId::sensors);
     }
-    auto connection = SensorCache.find(sensorConnection);
-    if (connection == SensorCache.end())
+    else
+    {
+        IPMI_PROBE2(sensor_cache_hit, sensorConnection.c_str(),
+                    sensorPath.c_str());
+        cache::hit(cache::CacheId::sensors);
+    }
+    return findCachedSensor(connectionId, pathId, sensorMap, sampled);
+}
+
+#ifdef IPMI_THRESHOLD_SEL
+// Trigger reading and threshold of an alarm, scaled like the sensor's SDR.
+// Called from a match callback, so it only looks at what the sensor cache
+// already holds and never reads D-Bus; false if the host hasn't read the
+// sensor yet.
+static bool getThresholdEventData(const std::string &path,
+                                  const char *interface,
+                                  const char *thresholdName,
+                                  uint8_t &scaledReading,
+                                  uint8_t &scaledThreshold)
+{
+    auto sensor = sensorTree.find(path);
+    if (sensor == sensorTree.end() || sensor->second.empty())
     {
         return false;
     }
-    auto path = connection->second.find(sensorPath);
-    if (path == connection->second.end())
+    SensorMap sensorMap;
+    if (!findCachedSensor(
+            intern::names().find(sensor->second.begin()->first),
+            intern::paths().find(path), sensorMap))
     {
         return false;
     }
-    sensorMap = path->second;
+    auto valueObject = sensorMap.find("xyz.openbmc_project.Sensor.Value");
+    auto thresholdObject = sensorMap.find(interface);
+    if (valueObject == sensorMap.end() || thresholdObject == sensorMap.end())
+    {
+        return false;
+    }
+    auto reading = valueObject->second.find("Value");
+    auto threshold = thresholdObject->second.find(thresholdName);
+    if (reading == valueObject->second.end() ||
+        threshold == thresholdObject->second.end())
+    {
+        return false;
+    }
+
+    double max;
+    double min;
+    getSensorMaxMin(valueObject->second, max, min);
 
+    int16_t mValue = 0;
+    int16_t bValue = 0;
+    int8_t rExp = 0;
+    int8_t bExp = 0;
+    bool bSigned = false;
+    if (!getSensorAttributes(max, min, mValue, rExp, bValue, bExp, bSigned))
+    {
+        return false;
+    }
+
+    std::optional<uint8_t> readingValue = scaleIPMIValueFromDouble(
+        variant_ns::visit(VariantToDoubleVisitor(), reading->second), mValue,
+        rExp, bValue, bExp, bSigned);
+    std::optional<uint8_t> thresholdValue = scaleIPMIValueFromDouble(
+        variant_ns::visit(VariantToDoubleVisitor(), threshold->second), mValue,
+        rExp, bValue, bExp, bSigned);
+    if (!readingValue || !thresholdValue)
+    {
+        return false;
+    }
+    scaledReading = *readingValue;
+    scaledThreshold = *thresholdValue;
+    return true;
+}
+
+// Logs a threshold sensor event for an alarm transition, so hosts can follow
+// crossings in the SEL instead of polling Get Sensor Event Status. It runs
+// in the thresholdChanged match callback, so past resolving the SEL logger
+// once it doesn't wait on D-Bus replies.
+static void logThresholdEvent(const std::string &path,
+                              const std::string &alarm, bool assert)
+{
+    struct ThresholdEvent
+    {
+        const char *interface;
+        const char *threshold;
+        uint8_t offset; // threshold event offset, IPMI table 42-2
+    };
+    static const boost::container::flat_map<std::string, ThresholdEvent>
+        thresholdEvents{
+            {"WarningAlarmHigh",
+             {"xyz.openbmc_project.Sensor.Threshold.Warning", "WarningHigh",
+              0x07}},
+            {"WarningAlarmLow",
+             {"xyz.openbmc_project.Sensor.Threshold.Warning", "WarningLow",
+              0x00}},
+            {"CriticalAlarmHigh",
+             {"xyz.openbmc_project.Sensor.Threshold.Critical", "CriticalHigh",
+              0x09}},
+            {"CriticalAlarmLow",
+             {"xyz.openbmc_project.Sensor.Threshold.Critical", "CriticalLow",
+              0x02}}};
+    // event data 1: trigger reading in byte 2, trigger threshold in byte 3
+    constexpr uint8_t thresholdEventData = 0x50;
+    constexpr uint16_t bmcGeneratorID = 0x20;
+
+    auto event = thresholdEvents.find(alarm);
+    if (event == thresholdEvents.end())
+    {
+        return;
+    }
+    // the event enable masks have a bit per offset
+    const SensorEventEnable &enable =
+        getSensorEventEnable(intern::paths().intern(path));
+    uint16_t disabled =
+        assert ? enable.assertionsDisabled : enable.deassertionsDisabled;
+    if (disabled & (1 << event->second.offset))
+    {
+        return;
+    }
+    if (getSensorNumberFromPath(path) == 0xFF)
+    {
+        // not an IPMI sensor
+        return;
+    }
+    // event data 1 says whether bytes 2 and 3 hold the trigger reading and
+    // threshold or are unspecified (0xFF)
+    std::vector<uint8_t> eventData{event->second.offset, 0xFF, 0xFF};
+    if (getThresholdEventData(path, event->second.interface,
+                              event->second.threshold, eventData[1],
+                              eventData[2]))
+    {
+        eventData[0] |= thresholdEventData;
+    }
+
+    // Resolved once, IpmiSelAdd is then sent without waiting for the reply.
+    // A failed add forgets the service in case the logger moved.
+    static std::string selService;
+    if (selService.empty())
+    {
+        try
+        {
+            selService =
+                accounting::getService(dbus, ipmiSELAddInterface, ipmiSELPath);
+        }
+        catch (sdbusplus::exception_t &e)
+        {
+            static ipmi::ratelog::Site site("logThresholdEvent.service");
+            ipmi::ratelog::log<phosphor::logging::level::ERR>(
+                site, "thresholdChanged: no SEL logger",
+                ipmi::ratelog::entry("SENSOR=%s", path.c_str()),
+                ipmi::ratelog::entry("WHAT=%s", e.what()));
+            return;
+        }
+    }
+    std::shared_ptr<sdbusplus::asio::connection> conn = getSdBus();
+    if (!conn)
+    {
+        return;
+    }
+    conn->async_method_call(
+        [path](const boost::system::error_code &ec) {
+            if (!ec)
+            {
+                return;
+            }
+            selService.clear();
+            static ipmi::ratelog::Site site("logThresholdEvent.add");
+            ipmi::ratelog::log<phosphor::logging::level::ERR>(
+                site, "thresholdChanged: failed to log SEL event",
+                ipmi::ratelog::entry("SENSOR=%s", path.c_str()),
+                ipmi::ratelog::entry("WHAT=%s", ec.message().c_str()));
+        },
+        selService, ipmiSELPath, ipmiSELAddInterface, "IpmiSelAdd",
+        ipmiSELAddMessage, path, eventData, assert, bmcGeneratorID);
+}
+#endif
+
+// sensor label from its path, with '_' as ' ' like the SDR id string
+static std::string getSensorName(const std::string &path)
+{
+    std::string name = path.substr(path.rfind('/') + 1);
+    std::replace(name.begin(), name.end(), '_', ' ');
+    return name;
+}
+
+// names match ignoring case and '_' versus ' '
+static std::string normalizeSensorName(std::string name)
+{
+    for (char &c : name)
+    {
+        c = c == '_' ? ' ' : std::tolower(static_cast<unsigned char>(c));
+    }
+    return name;
+}
+
+static bool updateSensorNameIndex()
+{
+    if (sensorTree.empty() && !getSensorSubtree(sensorTree))
+    {
+        return false;
+    }
+    if (!sensorNameIndex.byPath.empty())
+    {
+        return true;
+    }
+
+    sensorNameIndex.byName.clear();
+    sensorNameIndex.byName.reserve(sensorTree.size() * 2);
+    sensorNameIndex.byPath.reserve(sensorTree.size());
+    uint16_t recordId = 0;
+    for (const auto &sensor : sensorTree)
+    {
+        sensorNameIndex.byPath.emplace(intern::paths().intern(sensor.first),
+                                       recordId);
+        // the first sensor keeps a name used twice; the truncated SDR id
+        // string finds the sensor too
+        std::string name = normalizeSensorName(getSensorName(sensor.first));
+        if (name.size() > FULL_RECORD_ID_STR_MAX_LENGTH)
+        {
+            sensorNameIndex.byName.emplace(
+                name.substr(0, FULL_RECORD_ID_STR_MAX_LENGTH), recordId);
+        }
+        sensorNameIndex.byName.emplace(std::move(name), recordId);
+        recordId++;
+    }
     return true;
 }
 
@@ -275,14 +752,14 @@ ipmi::RspType<> ipmiSenPlatformEvent(ipmi::message::Payload &p)
 
     std::string sensorPath = getPathFromSensorNumber(sensorNum);
     std::string service =
-        ipmi::getService(dbus, ipmiSELAddInterface, ipmiSELPath);
+        accounting::getService(dbus, ipmiSELAddInterface, ipmiSELPath);
     sdbusplus::message::message writeSEL = dbus.new_method_call(
         service.c_str(), ipmiSELPath, ipmiSELAddInterface, "IpmiSelAdd");
     writeSEL.append(ipmiSELAddMessage, sensorPath, eventData, assert,
                     static_cast<uint16_t>(generatorID));
     try
     {
-        dbus.call(writeSEL);
+        accounting::call(dbus, writeSEL);
     }
     catch (sdbusplus::exception_t &e)
     {
@@ -305,6 +782,18 @@ ipmi::RspType<uint8_t, uint8_t, uint8_t, std::optional<uint8_t>>
         return ipmi::response(status);
     }
 
+    intern::Id pathId = intern::paths().intern(path);
+    const SensorEventEnable &enable = getSensorEventEnable(pathId);
+    // event and scanning enable bits are in the same place as in
+    // Get Sensor Event Enable
+    uint8_t operation = sensorEventEnableByte(enable);
+    if (!enable.scanning || isPoweredOff(pathId, path))
+    {
+        operation |= static_cast<uint8_t>(
+            IPMISensorReadingByte2::readingStateUnavailable);
+        return ipmi::responseSuccess(0, operation, 0, std::nullopt);
+    }
+
     SensorMap sensorMap;
     if (!getSensorMap(connection, path, sensorMap))
     {
@@ -335,13 +824,12 @@ ipmi::RspType<uint8_t, uint8_t, uint8_t, std::optional<uint8_t>>
         return ipmi::responseResponseError();
     }
 
-    uint8_t value =
+    std::optional<uint8_t> value =
         scaleIPMIValueFromDouble(reading, mValue, rExp, bValue, bExp, bSigned);
-    uint8_t operation =
-        static_cast<uint8_t>(IPMISensorReadingByte2::sensorScanningEnable);
-    operation |=
-        static_cast<uint8_t>(IPMISensorReadingByte2::eventMessagesEnable);
-
+    if (!value)
+    {
+        return ipmi::responseResponseError();
+    }
     uint8_t thresholds = 0;
 
     auto warningObject =
@@ -393,41 +881,32 @@ ipmi::RspType<uint8_t, uint8_t, uint8_t, std::optional<uint8_t>>
     }
 
     // no discrete as of today so optional byte is never returned
-    return ipmi::responseSuccess(value, operation, thresholds, std::nullopt);
+    return ipmi::responseSuccess(*value, operation, thresholds, std::nullopt);
 }
 
-ipmi_ret_t ipmiSenSetSensorThresholds(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
-                                      ipmi_request_t request,
-                                      ipmi_response_t response,
-                                      ipmi_data_len_t dataLen,
-                                      ipmi_context_t context)
+// validates a Set Sensor Thresholds request against the cached sensor map
+// and returns the threshold properties to write, none if the mask is empty
+static ipmi_ret_t
+    getThresholdWrites(const SensorThresholdReq &req,
+                       std::vector<pipeline::PropertyWrite> &writes)
 {
-    if (*dataLen != 8)
-    {
-        *dataLen = 0;
-        return IPMI_CC_REQ_DATA_LEN_INVALID;
-    }
-    *dataLen = 0;
-
-    SensorThresholdReq *req = static_cast<SensorThresholdReq *>(request);
-
     // upper two bits reserved
-    if (req->mask & 0xC0)
+    if (req.mask & 0xC0)
     {
         return IPMI_CC_INVALID_FIELD_REQUEST;
     }
 
     // lower nc and upper nc not suppported on any sensor
-    if ((req->mask & static_cast<uint8_t>(
-                         SensorThresholdReqEnable::setLowerNonRecoverable)) ||
-        (req->mask & static_cast<uint8_t>(
-                         SensorThresholdReqEnable::setUpperNonRecoverable)))
+    if ((req.mask & static_cast<uint8_t>(
+                        SensorThresholdReqEnable::setLowerNonRecoverable)) ||
+        (req.mask & static_cast<uint8_t>(
+                        SensorThresholdReqEnable::setUpperNonRecoverable)))
     {
         return IPMI_CC_INVALID_FIELD_REQUEST;
     }
 
     // if no bits are set in the mask, nothing to do
-    if (!(req->mask))
+    if (!(req.mask))
     {
         return IPMI_CC_OK;
     }
@@ -435,7 +914,7 @@ ipmi_ret_t ipmiSenSetSensorThresholds(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     std::string connection;
     std::string path;
 
-    ipmi_ret_t status = getSensorConnection(req->sensorNum, connection, path);
+    ipmi_ret_t status = getSensorConnection(req.sensorNum, connection, path);
     if (status)
     {
         return status;
@@ -468,17 +947,17 @@ ipmi_ret_t ipmiSenSetSensorThresholds(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     }
 
     bool setLowerCritical =
-        req->mask &
+        req.mask &
         static_cast<uint8_t>(SensorThresholdReqEnable::setLowerCritical);
     bool setUpperCritical =
-        req->mask &
+        req.mask &
         static_cast<uint8_t>(SensorThresholdReqEnable::setUpperCritical);
 
     bool setLowerWarning =
-        req->mask &
+        req.mask &
         static_cast<uint8_t>(SensorThresholdReqEnable::setLowerNonCritical);
     bool setUpperWarning =
-        req->mask &
+        req.mask &
         static_cast<uint8_t>(SensorThresholdReqEnable::setUpperNonCritical);
 
     // store a vector of property name, value to set, and interface
@@ -504,7 +983,7 @@ ipmi_ret_t ipmiSenSetSensorThresholds(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
             {
                 return IPMI_CC_INVALID_FIELD_REQUEST;
             }
-            thresholdsToSet.emplace_back("CriticalLow", req->lowerCritical,
+            thresholdsToSet.emplace_back("CriticalLow", req.lowerCritical,
                                          findThreshold->first);
         }
         if (setUpperCritical)
@@ -514,7 +993,7 @@ ipmi_ret_t ipmiSenSetSensorThresholds(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
             {
                 return IPMI_CC_INVALID_FIELD_REQUEST;
             }
-            thresholdsToSet.emplace_back("CriticalHigh", req->upperCritical,
+            thresholdsToSet.emplace_back("CriticalHigh", req.upperCritical,
                                          findThreshold->first);
         }
     }
@@ -533,7 +1012,7 @@ ipmi_ret_t ipmiSenSetSensorThresholds(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
             {
                 return IPMI_CC_INVALID_FIELD_REQUEST;
             }
-            thresholdsToSet.emplace_back("WarningLow", req->lowerNonCritical,
+            thresholdsToSet.emplace_back("WarningLow", req.lowerNonCritical,
                                          findThreshold->first);
         }
         if (setUpperWarning)
@@ -543,7 +1022,7 @@ ipmi_ret_t ipmiSenSetSensorThresholds(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
             {
                 return IPMI_CC_INVALID_FIELD_REQUEST;
             }
-            thresholdsToSet.emplace_back("WarningHigh", req->upperNonCritical,
+            thresholdsToSet.emplace_back("WarningHigh", req.upperNonCritical,
                                          findThreshold->first);
         }
     }
@@ -554,95 +1033,273 @@ ipmi_ret_t ipmiSenSetSensorThresholds(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         double valueToSet = ((mValue * std::get<thresholdValue>(property)) +
                              (bValue * std::pow(10, bExp))) *
                             std::pow(10, rExp);
-        setDbusProperty(dbus, connection, path, std::get<interface>(property),
-                        std::get<propertyName>(property),
-                        ipmi::Value(valueToSet));
+        writes.push_back({connection, path, std::get<interface>(property),
+                          std::get<propertyName>(property),
+                          ipmi::Value(valueToSet)});
     }
 
     return IPMI_CC_OK;
 }
 
-IPMIThresholds getIPMIThresholds(const SensorMap &sensorMap)
+// Get Sensor Reading High Resolution: the cached engineering value of up to
+// maxHighResSensors consecutive sensors, as signed thousandths of the
+// sensor's unit, so hosts need no SDR to convert it. Per sensor:
+//   sensor number, flags, value (int32), sample time (uint32 epoch seconds)
+// all little endian. The range stops at the last sensor.
+ipmi::RspType<std::vector<uint8_t>>
+    ipmiSenGetSensorReadingHighRes(uint8_t sensnum,
+                                   std::optional<uint8_t> count)
 {
-    IPMIThresholds resp;
-    auto warningInterface =
-        sensorMap.find("xyz.openbmc_project.Sensor.Threshold.Warning");
-    auto criticalInterface =
-        sensorMap.find("xyz.openbmc_project.Sensor.Threshold.Critical");
+    constexpr uint8_t maxHighResSensors = 16;
+    constexpr double highResScale = 1000.0;
+    constexpr uint8_t flagStale = 1 << 0;
+    constexpr uint8_t flagUnavailable = 1 << 1;
+    constexpr uint8_t flagScanningDisabled = 1 << 2;
 
-    if ((warningInterface != sensorMap.end()) ||
-        (criticalInterface != sensorMap.end()))
+    uint8_t sensors = count.value_or(1);
+    if (sensors == 0 || sensors > maxHighResSensors)
     {
-        auto sensorPair = sensorMap.find("xyz.openbmc_project.Sensor.Value");
+        return ipmi::responseInvalidFieldRequest();
+    }
 
-        if (sensorPair == sensorMap.end())
+    std::vector<uint8_t> readings;
+    auto steadyNow = std::chrono::steady_clock::now();
+    auto systemNow = std::chrono::system_clock::now();
+    for (unsigned int num = sensnum; num < sensnum + sensors && num < 0xFF;
+         num++)
+    {
+        std::string connection;
+        std::string path;
+        auto status = getSensorConnection(num, connection, path);
+        if (status)
         {
-            // should not have been able to find a sensor not implementing
-            // the sensor object
-            throw std::runtime_error("Invalid sensor map");
+            if (num == sensnum)
+            {
+                return ipmi::response(status);
+            }
+            break;
         }
 
-        double max;
-        double min;
-        getSensorMaxMin(sensorPair->second, max, min);
-
-        int16_t mValue = 0;
-        int16_t bValue = 0;
-        int8_t rExp = 0;
-        int8_t bExp = 0;
-        bool bSigned = false;
-
-        if (!getSensorAttributes(max, min, mValue, rExp, bValue, bExp, bSigned))
+        uint8_t flags = 0;
+        int32_t value = 0;
+        uint32_t timestamp = 0;
+        intern::Id pathId = intern::paths().intern(path);
+        if (!getSensorEventEnable(pathId).scanning)
         {
-            throw std::runtime_error("Invalid sensor atrributes");
+            flags |= flagScanningDisabled;
         }
-        if (warningInterface != sensorMap.end())
-        {
-            auto &warningMap = warningInterface->second;
+        bool poweredOff = isPoweredOff(pathId, path);
 
-            auto warningHigh = warningMap.find("WarningHigh");
-            auto warningLow = warningMap.find("WarningLow");
-
-            if (warningHigh != warningMap.end())
+        SensorMap sensorMap;
+        std::chrono::steady_clock::time_point sampled;
+        std::optional<double> reading;
+        if (getSensorMap(connection, path, sensorMap, &sampled))
+        {
+            auto sensorObject =
+                sensorMap.find("xyz.openbmc_project.Sensor.Value");
+            if (sensorObject != sensorMap.end())
             {
-
-                double value = variant_ns::visit(VariantToDoubleVisitor(),
-                                                 warningHigh->second);
-                resp.warningHigh = scaleIPMIValueFromDouble(
-                    value, mValue, rExp, bValue, bExp, bSigned);
+                auto valueFind = sensorObject->second.find("Value");
+                if (valueFind != sensorObject->second.end())
+                {
+                    reading = variant_ns::visit(VariantToDoubleVisitor(),
+                                                valueFind->second) *
+                              highResScale;
+                }
             }
-            if (warningLow != warningMap.end())
+        }
+        if (reading && std::isfinite(*reading) && !poweredOff)
+        {
+            value = static_cast<int32_t>(std::clamp(
+                std::round(*reading),
+                static_cast<double>(std::numeric_limits<int32_t>::min()),
+                static_cast<double>(std::numeric_limits<int32_t>::max())));
+            timestamp = std::chrono::duration_cast<std::chrono::seconds>(
+                            (systemNow - (steadyNow - sampled))
+                                .time_since_epoch())
+                            .count();
+            if (std::chrono::duration_cast<std::chrono::seconds>(steadyNow -
+                                                                 sampled)
+                    .count() > sensorMapUpdatePeriod)
             {
-                double value = variant_ns::visit(VariantToDoubleVisitor(),
-                                                 warningLow->second);
-                resp.warningLow = scaleIPMIValueFromDouble(
-                    value, mValue, rExp, bValue, bExp, bSigned);
+                flags |= flagStale;
             }
         }
-        if (criticalInterface != sensorMap.end())
+        else
         {
-            auto &criticalMap = criticalInterface->second;
+            flags |= flagUnavailable;
+        }
 
-            auto criticalHigh = criticalMap.find("CriticalHigh");
-            auto criticalLow = criticalMap.find("CriticalLow");
+        readings.push_back(static_cast<uint8_t>(num));
+        readings.push_back(flags);
+        for (size_t byte = 0; byte < sizeof(value); byte++)
+        {
+            readings.push_back(static_cast<uint32_t>(value) >> (byte * 8));
+        }
+        for (size_t byte = 0; byte < sizeof(timestamp); byte++)
+        {
+            readings.push_back(timestamp >> (byte * 8));
+        }
+    }
 
-            if (criticalHigh != criticalMap.end())
+    return ipmi::responseSuccess(readings);
+}
+
+// Get Sensor By Name: resolves a sensor name (as in the SDR id string or
+// the D-Bus label, case and '_' insensitive) or a D-Bus path to its sensor
+// number and SDR record id, or a sensor number back to its name. Sensors past
+// 0xFE have no sensor number and return parameter out of range.
+ipmi::RspType<uint8_t,             // sensor number
+              uint16_t,            // record id
+              std::vector<uint8_t> // name
+              >
+    ipmiSenGetSensorByName(uint8_t lookup, std::vector<uint8_t> key)
+{
+    constexpr uint8_t lookupName = 0;
+    constexpr uint8_t lookupPath = 1;
+    constexpr uint8_t lookupNumber = 2;
+
+    if (key.empty())
+    {
+        return ipmi::responseReqDataLenInvalid();
+    }
+    if (!updateSensorNameIndex())
+    {
+        return ipmi::responseResponseError();
+    }
+
+    size_t recordId = 0;
+    if (lookup == lookupName || lookup == lookupPath)
+    {
+        std::string str(key.begin(), key.end());
+        if (lookup == lookupName)
+        {
+            auto find = sensorNameIndex.byName.find(normalizeSensorName(str));
+            if (find == sensorNameIndex.byName.end())
             {
-                double value = variant_ns::visit(VariantToDoubleVisitor(),
-                                                 criticalHigh->second);
-                resp.criticalHigh = scaleIPMIValueFromDouble(
-                    value, mValue, rExp, bValue, bExp, bSigned);
+                return ipmi::responseSensorInvalid();
             }
-            if (criticalLow != criticalMap.end())
+            recordId = find->second;
+        }
+        else
+        {
+            auto find =
+                sensorNameIndex.byPath.find(intern::paths().find(str));
+            if (find == sensorNameIndex.byPath.end())
             {
-                double value = variant_ns::visit(VariantToDoubleVisitor(),
-                                                 criticalLow->second);
-                resp.criticalLow = scaleIPMIValueFromDouble(
-                    value, mValue, rExp, bValue, bExp, bSigned);
+                return ipmi::responseSensorInvalid();
             }
+            recordId = find->second;
+        }
+    }
+    else if (lookup == lookupNumber)
+    {
+        if (key.size() != 1)
+        {
+            return ipmi::responseReqDataLenInvalid();
+        }
+        recordId = key[0];
+        if (recordId >= sensorTree.size())
+        {
+            return ipmi::responseSensorInvalid();
         }
     }
-    return resp;
+    else
+    {
+        return ipmi::responseInvalidFieldRequest();
+    }
+
+    // the sensor number is the record id, and 0xFF is reserved
+    if (recordId >= 0xFF)
+    {
+        return ipmi::responseParmOutOfRange();
+    }
+
+    std::string name = getSensorName((sensorTree.begin() + recordId)->first);
+    std::vector<uint8_t> nameData(name.begin(), name.end());
+    return ipmi::responseSuccess(static_cast<uint8_t>(recordId),
+                                 static_cast<uint16_t>(recordId), nameData);
+}
+
+ipmi_ret_t ipmiSenSetSensorThresholds(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
+                                      ipmi_request_t request,
+                                      ipmi_response_t response,
+                                      ipmi_data_len_t dataLen,
+                                      ipmi_context_t context)
+{
+    if (*dataLen != 8)
+    {
+        *dataLen = 0;
+        return IPMI_CC_REQ_DATA_LEN_INVALID;
+    }
+    *dataLen = 0;
+
+    SensorThresholdReq *req = static_cast<SensorThresholdReq *>(request);
+
+    std::vector<pipeline::PropertyWrite> writes;
+    ipmi_ret_t status = getThresholdWrites(*req, writes);
+    if (status)
+    {
+        return status;
+    }
+
+    for (const auto &write : writes)
+    {
+        accounting::setDbusProperty(dbus, write.service, write.path,
+                                    write.interface, write.property,
+                                    write.value);
+    }
+
+    return IPMI_CC_OK;
+}
+
+// Sets thresholds on many sensors at once. The request is a packed list of
+// Set Sensor Thresholds requests, each validated like the standard command;
+// the property writes of all valid entries go out pipelined on a private
+// connection. The response has a completion code per entry.
+ipmi::RspType<std::vector<uint8_t>>
+    ipmiSenSetSensorThresholdsBulk(std::vector<uint8_t> entries)
+{
+    if (entries.empty() || entries.size() % sizeof(SensorThresholdReq))
+    {
+        return ipmi::responseReqDataLenInvalid();
+    }
+    size_t count = entries.size() / sizeof(SensorThresholdReq);
+
+    std::vector<uint8_t> status(count, IPMI_CC_OK);
+    std::vector<pipeline::PropertyWrite> writes;
+    // entry each write belongs to
+    std::vector<size_t> owners;
+    for (size_t ii = 0; ii < count; ii++)
+    {
+        SensorThresholdReq req;
+        std::memcpy(&req, entries.data() + ii * sizeof(req), sizeof(req));
+        size_t first = writes.size();
+        status[ii] = getThresholdWrites(req, writes);
+        if (status[ii])
+        {
+            writes.resize(first);
+        }
+        owners.resize(writes.size(), ii);
+    }
+
+    static sdbusplus::bus::bus pipelineBus(sdbusplus::bus::new_system());
+    std::vector<int> results = pipeline::setProperties(pipelineBus, writes);
+    for (size_t ii = 0; ii < results.size(); ii++)
+    {
+        if (results[ii] < 0)
+        {
+            phosphor::logging::log<phosphor::logging::level::ERR>(
+                "Failed to set threshold",
+                phosphor::logging::entry("PATH=%s", writes[ii].path.c_str()),
+                phosphor::logging::entry("PROPERTY=%s",
+                                         writes[ii].property.c_str()),
+                phosphor::logging::entry("ERRNO=%d", -results[ii]));
+            status[owners[ii]] = IPMI_CC_UNSPECIFIED_ERROR;
+        }
+    }
+
+    return ipmi::responseSuccess(status);
 }
 
 ipmi::RspType<uint8_t, // readable
@@ -669,12 +1326,8 @@ ipmi::RspType<uint8_t, // readable
         return ipmi::responseResponseError();
     }
 
-    IPMIThresholds thresholdData;
-    try
-    {
-        thresholdData = getIPMIThresholds(sensorMap);
-    }
-    catch (std::exception &)
+    std::optional<IPMIThresholds> thresholdData = getIPMIThresholds(sensorMap);
+    if (!thresholdData)
     {
         return ipmi::responseResponseError();
     }
@@ -687,30 +1340,30 @@ ipmi::RspType<uint8_t, // readable
     uint8_t upperCritical = 0;
     uint8_t upperNonRecoverable = 0;
 
-    if (thresholdData.warningHigh)
+    if (thresholdData->warningHigh)
     {
         readable |=
             1 << static_cast<uint8_t>(IPMIThresholdRespBits::upperNonCritical);
-        upperNC = *thresholdData.warningHigh;
+        upperNC = *thresholdData->warningHigh;
     }
-    if (thresholdData.warningLow)
+    if (thresholdData->warningLow)
     {
         readable |=
             1 << static_cast<uint8_t>(IPMIThresholdRespBits::lowerNonCritical);
-        lowerNC = *thresholdData.warningLow;
+        lowerNC = *thresholdData->warningLow;
     }
 
-    if (thresholdData.criticalHigh)
+    if (thresholdData->criticalHigh)
     {
         readable |=
             1 << static_cast<uint8_t>(IPMIThresholdRespBits::upperCritical);
-        upperCritical = *thresholdData.criticalHigh;
+        upperCritical = *thresholdData->criticalHigh;
     }
-    if (thresholdData.criticalLow)
+    if (thresholdData->criticalLow)
     {
         readable |=
             1 << static_cast<uint8_t>(IPMIThresholdRespBits::lowerCritical);
-        lowerCritical = *thresholdData.criticalLow;
+        lowerCritical = *thresholdData->criticalLow;
     }
 
     return ipmi::responseSuccess(readable, lowerNC, lowerCritical,
@@ -718,6 +1371,69 @@ ipmi::RspType<uint8_t, // readable
                                  upperNonRecoverable);
 }
 
+ipmi::RspType<> ipmiSenSetSensorEventEnable(
+    uint8_t sensnum, uint8_t enables, std::optional<uint8_t> assertLSB,
+    std::optional<uint8_t> assertMSB, std::optional<uint8_t> deassertLSB,
+    std::optional<uint8_t> deassertMSB)
+{
+    // bits [3:0] are reserved, the spec has senders write them as 0 but
+    // receivers ignore them, so they are masked off rather than rejected
+    constexpr uint8_t selectedShift = 4;
+    constexpr uint8_t selectedMask = 0x3;
+    auto selected = static_cast<IPMISensorEventEnableSelected>(
+        (enables >> selectedShift) & selectedMask);
+    if (selected != IPMISensorEventEnableSelected::noChange &&
+        selected != IPMISensorEventEnableSelected::enableSelected &&
+        selected != IPMISensorEventEnableSelected::disableSelected)
+    {
+        return ipmi::responseInvalidFieldRequest();
+    }
+
+    std::string connection;
+    std::string path;
+
+    auto status = getSensorConnection(sensnum, connection, path);
+    if (status)
+    {
+        return ipmi::response(status);
+    }
+
+    intern::Id pathId = intern::paths().intern(path);
+    SensorEventEnable enable = getSensorEventEnable(pathId);
+    enable.events =
+        enables &
+        static_cast<uint8_t>(IPMISensorEventEnableByte2::eventMessagesEnable);
+    enable.scanning =
+        enables &
+        static_cast<uint8_t>(IPMISensorEventEnableByte2::sensorScanningEnable);
+
+    uint16_t assertions = assertLSB.value_or(0) | assertMSB.value_or(0) << 8;
+    uint16_t deassertions =
+        deassertLSB.value_or(0) | deassertMSB.value_or(0) << 8;
+    if (selected == IPMISensorEventEnableSelected::enableSelected)
+    {
+        enable.assertionsDisabled &= ~assertions;
+        enable.deassertionsDisabled &= ~deassertions;
+    }
+    else if (selected == IPMISensorEventEnableSelected::disableSelected)
+    {
+        enable.assertionsDisabled |= assertions;
+        enable.deassertionsDisabled |= deassertions;
+    }
+
+    if (enable.scanning && enable.events && !enable.assertionsDisabled &&
+        !enable.deassertionsDisabled)
+    {
+        // back to the defaults, nothing to remember
+        sensorEventEnables.erase(pathId);
+    }
+    else
+    {
+        sensorEventEnables[pathId] = enable;
+    }
+    return ipmi::responseSuccess();
+}
+
 ipmi_ret_t ipmiSenGetSensorEventEnable(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                                        ipmi_request_t request,
                                        ipmi_response_t response,
@@ -747,6 +1463,8 @@ ipmi_ret_t ipmiSenGetSensorEventEnable(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     {
         return IPMI_CC_RESPONSE_ERROR;
     }
+    const SensorEventEnable &enable =
+        getSensorEventEnable(intern::paths().intern(path));
 
     auto warningInterface =
         sensorMap.find("xyz.openbmc_project.Sensor.Threshold.Warning");
@@ -764,8 +1482,7 @@ ipmi_ret_t ipmiSenGetSensorEventEnable(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         // assume all threshold sensors
         auto resp = static_cast<SensorEventEnableResp *>(response);
 
-        resp->enabled = static_cast<uint8_t>(
-            IPMISensorEventEnableByte2::sensorScanningEnable);
+        resp->enabled = sensorEventEnableByte(enable);
         if (warningInterface != sensorMap.end())
         {
             auto &warningMap = warningInterface->second;
@@ -809,6 +1526,15 @@ ipmi_ret_t ipmiSenGetSensorEventEnable(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                     IPMISensorEventEnableThresholds::lowerCriticalGoingHigh);
             }
         }
+        // less whatever the host turned off
+        resp->assertionEnabledLSB &=
+            ~static_cast<uint8_t>(enable.assertionsDisabled);
+        resp->assertionEnabledMSB &=
+            ~static_cast<uint8_t>(enable.assertionsDisabled >> 8);
+        resp->deassertionEnabledLSB &=
+            ~static_cast<uint8_t>(enable.deassertionsDisabled);
+        resp->deassertionEnabledMSB &=
+            ~static_cast<uint8_t>(enable.deassertionsDisabled >> 8);
         *dataLen =
             sizeof(SensorEventEnableResp); // todo only return needed bytes
     }
@@ -817,10 +1543,7 @@ ipmi_ret_t ipmiSenGetSensorEventEnable(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     {
         *dataLen = 1;
         auto resp = static_cast<uint8_t *>(response);
-        *resp = static_cast<uint8_t>(
-            IPMISensorEventEnableByte2::eventMessagesEnable);
-        *resp |= static_cast<uint8_t>(
-            IPMISensorEventEnableByte2::sensorScanningEnable);
+        *resp = sensorEventEnableByte(enable);
     }
     return IPMI_CC_OK;
 }
@@ -864,17 +1587,23 @@ ipmi_ret_t ipmiSenGetSensorEventStatus(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     auto responseClear = static_cast<uint8_t *>(response);
     std::fill(responseClear, responseClear + sizeof(SensorEventStatusResp), 0);
     auto resp = static_cast<SensorEventStatusResp *>(response);
-    resp->enabled =
-        static_cast<uint8_t>(IPMISensorEventEnableByte2::sensorScanningEnable);
-
-    std::optional<bool> criticalDeassertHigh =
-        thresholdDeassertMap[path]["CriticalAlarmHigh"];
-    std::optional<bool> criticalDeassertLow =
-        thresholdDeassertMap[path]["CriticalAlarmLow"];
-    std::optional<bool> warningDeassertHigh =
-        thresholdDeassertMap[path]["WarningAlarmHigh"];
-    std::optional<bool> warningDeassertLow =
-        thresholdDeassertMap[path]["WarningAlarmLow"];
+    intern::Id pathId = intern::paths().intern(path);
+    resp->enabled = sensorEventEnableByte(getSensorEventEnable(pathId));
+
+    static const intern::Id criticalAlarmHigh =
+        intern::names().intern("CriticalAlarmHigh");
+    static const intern::Id criticalAlarmLow =
+        intern::names().intern("CriticalAlarmLow");
+    static const intern::Id warningAlarmHigh =
+        intern::names().intern("WarningAlarmHigh");
+    static const intern::Id warningAlarmLow =
+        intern::names().intern("WarningAlarmLow");
+
+    auto &deasserts = thresholdDeassertMap[pathId];
+    std::optional<bool> criticalDeassertHigh = deasserts[criticalAlarmHigh];
+    std::optional<bool> criticalDeassertLow = deasserts[criticalAlarmLow];
+    std::optional<bool> warningDeassertHigh = deasserts[warningAlarmHigh];
+    std::optional<bool> warningDeassertLow = deasserts[warningAlarmLow];
 
     if (criticalDeassertHigh && !*criticalDeassertHigh)
     {
@@ -900,8 +1629,6 @@ ipmi_ret_t ipmiSenGetSensorEventStatus(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     if ((warningInterface != sensorMap.end()) ||
         (criticalInterface != sensorMap.end()))
     {
-        resp->enabled = static_cast<uint8_t>(
-            IPMISensorEventEnableByte2::eventMessagesEnable);
         if (warningInterface != sensorMap.end())
         {
             auto &warningMap = warningInterface->second;
@@ -1177,181 +1904,12 @@ ipmi::RspType<uint16_t,            // next record ID
     {
         return ipmi::responseResponseError();
     }
-    uint8_t sensornumber = (recordID & 0xFF);
-    get_sdr::SensorDataFullRecord record = {0};
-
-    record.header.record_id_msb = recordID << 8;
-    record.header.record_id_lsb = recordID & 0xFF;
-    record.header.sdr_version = ipmiSdrVersion;
-    record.header.record_type = get_sdr::SENSOR_DATA_FULL_RECORD;
-    record.header.record_length = sizeof(get_sdr::SensorDataFullRecord) -
-                                  sizeof(get_sdr::SensorDataRecordHeader);
-    record.key.owner_id = 0x20;
-    record.key.owner_lun = 0x0;
-    record.key.sensor_number = sensornumber;
-
-    record.body.entity_id = 0x0;
-    record.body.entity_instance = 0x01;
-    record.body.sensor_capabilities = 0x68; // auto rearm - todo hysteresis
-    record.body.sensor_type = getSensorTypeFromPath(path);
-    std::string type = getSensorTypeStringFromPath(path);
-    auto typeCstr = type.c_str();
-    auto findUnits = sensorUnits.find(typeCstr);
-    if (findUnits != sensorUnits.end())
-    {
-        record.body.sensor_units_2_base =
-            static_cast<uint8_t>(findUnits->second);
-    } // else default 0x0 unspecified
-
-    record.body.event_reading_type = getSensorEventTypeFromPath(path);
-
-    auto sensorObject = sensorMap.find("xyz.openbmc_project.Sensor.Value");
-    if (sensorObject == sensorMap.end())
+    get_sdr::SensorDataFullRecord record;
+    if (!constructSensorSdr(recordID, path, sensorMap, record))
     {
         return ipmi::responseResponseError();
     }
 
-    auto maxObject = sensorObject->second.find("MaxValue");
-    auto minObject = sensorObject->second.find("MinValue");
-    double max = 128;
-    double min = -127;
-    if (maxObject != sensorObject->second.end())
-    {
-        max = variant_ns::visit(VariantToDoubleVisitor(), maxObject->second);
-    }
-
-    if (minObject != sensorObject->second.end())
-    {
-        min = variant_ns::visit(VariantToDoubleVisitor(), minObject->second);
-    }
-
-    int16_t mValue;
-    int8_t rExp;
-    int16_t bValue;
-    int8_t bExp;
-    bool bSigned;
-
-    if (!getSensorAttributes(max, min, mValue, rExp, bValue, bExp, bSigned))
-    {
-        return ipmi::responseResponseError();
-    }
-
-    // apply M, B, and exponents, M and B are 10 bit values, exponents are 4
-    record.body.m_lsb = mValue & 0xFF;
-
-    // move the smallest bit of the MSB into place (bit 9)
-    // the MSbs are bits 7:8 in m_msb_and_tolerance
-    uint8_t mMsb = (mValue & (1 << 8)) > 0 ? (1 << 6) : 0;
-
-    // assign the negative
-    if (mValue < 0)
-    {
-        mMsb |= (1 << 7);
-    }
-    record.body.m_msb_and_tolerance = mMsb;
-
-    record.body.b_lsb = bValue & 0xFF;
-
-    // move the smallest bit of the MSB into place
-    // the MSbs are bits 7:8 in b_msb_and_accuracy_lsb
-    uint8_t bMsb = (bValue & (1 << 8)) > 0 ? (1 << 6) : 0;
-
-    // assign the negative
-    if (bValue < 0)
-    {
-        bMsb |= (1 << 7);
-    }
-    record.body.b_msb_and_accuracy_lsb = bMsb;
-
-    record.body.r_b_exponents = bExp & 0x7;
-    if (bExp < 0)
-    {
-        record.body.r_b_exponents |= 1 << 3;
-    }
-    record.body.r_b_exponents = (rExp & 0x7) << 4;
-    if (rExp < 0)
-    {
-        record.body.r_b_exponents |= 1 << 7;
-    }
-
-    // todo fill out rest of units
-    if (bSigned)
-    {
-        record.body.sensor_units_1 = 1 << 7;
-    }
-
-    // populate sensor name from path
-    std::string name;
-    size_t nameStart = path.rfind("/");
-    if (nameStart != std::string::npos)
-    {
-        name = path.substr(nameStart + 1, std::string::npos - nameStart);
-    }
-
-    std::replace(name.begin(), name.end(), '_', ' ');
-    if (name.size() > FULL_RECORD_ID_STR_MAX_LENGTH)
-    {
-        name.resize(FULL_RECORD_ID_STR_MAX_LENGTH);
-    }
-    record.body.id_string_info = name.size();
-    std::strncpy(record.body.id_string, name.c_str(),
-                 sizeof(record.body.id_string));
-
-    IPMIThresholds thresholdData;
-    try
-    {
-        thresholdData = getIPMIThresholds(sensorMap);
-    }
-    catch (std::exception &)
-    {
-        return ipmi::responseResponseError();
-    }
-
-    if (thresholdData.criticalHigh)
-    {
-        record.body.upper_critical_threshold = *thresholdData.criticalHigh;
-        record.body.supported_deassertions[1] |= static_cast<uint8_t>(
-            IPMISensorEventEnableThresholds::upperCriticalGoingHigh);
-        record.body.supported_assertions[1] |= static_cast<uint8_t>(
-            IPMISensorEventEnableThresholds::upperCriticalGoingHigh);
-        record.body.discrete_reading_setting_mask[0] |=
-            static_cast<uint8_t>(IPMISensorReadingByte3::upperCritical);
-    }
-    if (thresholdData.warningHigh)
-    {
-        record.body.upper_noncritical_threshold = *thresholdData.warningHigh;
-        record.body.supported_deassertions[0] |= static_cast<uint8_t>(
-            IPMISensorEventEnableThresholds::upperNonCriticalGoingHigh);
-        record.body.supported_assertions[0] |= static_cast<uint8_t>(
-            IPMISensorEventEnableThresholds::upperNonCriticalGoingHigh);
-        record.body.discrete_reading_setting_mask[0] |=
-            static_cast<uint8_t>(IPMISensorReadingByte3::upperNonCritical);
-    }
-    if (thresholdData.criticalLow)
-    {
-        record.body.lower_critical_threshold = *thresholdData.criticalLow;
-        record.body.supported_deassertions[0] |= static_cast<uint8_t>(
-            IPMISensorEventEnableThresholds::lowerCriticalGoingLow);
-        record.body.supported_assertions[0] |= static_cast<uint8_t>(
-            IPMISensorEventEnableThresholds::lowerCriticalGoingLow);
-        record.body.discrete_reading_setting_mask[0] |=
-            static_cast<uint8_t>(IPMISensorReadingByte3::lowerCritical);
-    }
-    if (thresholdData.warningLow)
-    {
-        record.body.lower_noncritical_threshold = *thresholdData.warningLow;
-        record.body.supported_deassertions[0] |= static_cast<uint8_t>(
-            IPMISensorEventEnableThresholds::lowerNonCriticalGoingLow);
-        record.body.supported_assertions[0] |= static_cast<uint8_t>(
-            IPMISensorEventEnableThresholds::lowerNonCriticalGoingLow);
-        record.body.discrete_reading_setting_mask[0] |=
-            static_cast<uint8_t>(IPMISensorReadingByte3::lowerNonCritical);
-    }
-
-    // everything that is readable is setable
-    record.body.discrete_reading_setting_mask[1] =
-        record.body.discrete_reading_setting_mask[0];
-
     if (sizeof(get_sdr::SensorDataFullRecord) < (offset + bytesToRead))
     {
         bytesToRead = sizeof(get_sdr::SensorDataFullRecord) - offset;
@@ -1384,19 +1942,19 @@ void registerSensorFunctions()
         nullptr, ipmiSensorWildcardHandler, PRIVILEGE_OPERATOR);
 
     // <Platform Event>
-    ipmi::registerHandler(
+    ipmi::registerTimedHandler(
         ipmi::prioOemBase, ipmi::netFnSensor,
         static_cast<ipmi::Cmd>(ipmi::sensor_event::cmdPlatformEvent),
         ipmi::Privilege::Operator, ipmiSenPlatformEvent);
 
     // <Get Sensor Reading>
-    ipmi::registerHandler(
+    ipmi::registerTimedHandler(
         ipmi::prioOemBase, NETFUN_SENSOR,
         static_cast<ipmi::Cmd>(IPMINetfnSensorCmds::ipmiCmdGetSensorReading),
         ipmi::Privilege::User, ipmiSenGetSensorReading);
 
     // <Get Sensor Threshold>
-    ipmi::registerHandler(
+    ipmi::registerTimedHandler(
         ipmi::prioOemBase, NETFUN_SENSOR,
         static_cast<ipmi::Cmd>(IPMINetfnSensorCmds::ipmiCmdGetSensorThreshold),
         ipmi::Privilege::User, ipmiSenGetSensorThresholds);
@@ -1406,6 +1964,33 @@ void registerSensorFunctions()
         static_cast<ipmi_cmd_t>(IPMINetfnSensorCmds::ipmiCmdSetSensorThreshold),
         nullptr, ipmiSenSetSensorThresholds, PRIVILEGE_OPERATOR);
 
+    // <Set Sensor Event Enable>
+    ipmi::registerTimedHandler(
+        ipmi::prioOemBase, NETFUN_SENSOR,
+        static_cast<ipmi::Cmd>(
+            IPMINetfnSensorCmds::ipmiCmdSetSensorEventEnable),
+        ipmi::Privilege::Operator, ipmiSenSetSensorEventEnable);
+
+    // <Get Sensor Reading High Resolution>
+    ipmi::registerTimedHandler(
+        ipmi::prioOemBase, netfnIntcOEMGeneral,
+        static_cast<ipmi::Cmd>(
+            IPMINetfnIntelOEMGeneralCmd::cmdGetSensorReadingHighRes),
+        ipmi::Privilege::User, ipmiSenGetSensorReadingHighRes);
+
+    // <Get Sensor By Name>
+    ipmi::registerTimedHandler(
+        ipmi::prioOemBase, netfnIntcOEMGeneral,
+        static_cast<ipmi::Cmd>(IPMINetfnIntelOEMGeneralCmd::cmdGetSensorByName),
+        ipmi::Privilege::User, ipmiSenGetSensorByName);
+
+    // <Set Sensor Thresholds Bulk>
+    ipmi::registerTimedHandler(
+        ipmi::prioOemBase, netfnIntcOEMGeneral,
+        static_cast<ipmi::Cmd>(
+            IPMINetfnIntelOEMGeneralCmd::cmdSetSensorThresholdsBulk),
+        ipmi::Privilege::Operator, ipmiSenSetSensorThresholdsBulk);
+
     // <Get Sensor Event Enable>
     ipmiPrintAndRegister(NETFUN_SENSOR,
                          static_cast<ipmi_cmd_t>(
@@ -1446,12 +2031,12 @@ void registerSensorFunctions()
         nullptr, ipmiStorageReserveSDR, PRIVILEGE_USER);
 
     // <Get Sdr>
-    ipmi::registerHandler(
+    ipmi::registerTimedHandler(
         ipmi::prioOemBase, NETFUN_SENSOR,
         static_cast<ipmi::Cmd>(IPMINetfnSensorCmds::ipmiCmdGetDeviceSDR),
         ipmi::Privilege::User, ipmiStorageGetSDR);
 
-    ipmi::registerHandler(
+    ipmi::registerTimedHandler(
         ipmi::prioOemBase, NETFUN_STORAGE,
         static_cast<ipmi::Cmd>(IPMINetfnStorageCmds::ipmiCmdGetSDR),
         ipmi::Privilege::User, ipmiStorageGetSDR);
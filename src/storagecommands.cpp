@@ -14,19 +14,25 @@
 // limitations under the License.
 */
 
-#include <boost/container/flat_map.hpp>
 #include <boost/process.hpp>
+#include <chrono>
 #include <commandutils.hpp>
+#include <fruutils.hpp>
 #include <iostream>
 #include <ipmid/api.hpp>
+#include <memory>
+#include <oemcommands.hpp>
 #include <phosphor-ipmi-host/selutility.hpp>
 #include <phosphor-logging/log.hpp>
 #include <sdbusplus/message/types.hpp>
 #include <sdbusplus/timer.hpp>
 #include <sdrutils.hpp>
+#include <selutils.hpp>
 #include <stdexcept>
 #include <storagecommands.hpp>
 #include <string_view>
+#include <tracepoints.hpp>
+#include <tuple>
 
 namespace intel_oem::ipmi::sel::erase_time
 {
@@ -79,182 +85,67 @@ namespace storage
 {
 
 constexpr static const size_t maxMessageSize = 64;
-constexpr static const size_t maxFruSdrNameSize = 16;
-using ManagedObjectType = boost::container::flat_map<
-    sdbusplus::message::object_path,
-    boost::container::flat_map<
-        std::string, boost::container::flat_map<std::string, DbusVariant>>>;
-using ManagedEntry = std::pair<
-    sdbusplus::message::object_path,
-    boost::container::flat_map<
-        std::string, boost::container::flat_map<std::string, DbusVariant>>>;
-
-constexpr static const char* fruDeviceServiceName =
-    "xyz.openbmc_project.FruDevice";
 constexpr static const size_t cacheTimeoutSeconds = 10;
+constexpr static const size_t fruTransactionTimeoutSeconds = 60;
 
 // event direction is bit[7] of eventType where 1b = Deassertion event
 constexpr static const uint8_t deassertionEvent = 0x80;
 
-static std::vector<uint8_t> fruCache;
-static uint8_t cacheBus = 0xFF;
-static uint8_t cacheAddr = 0XFF;
-
-std::unique_ptr<phosphor::Timer> cacheTimer = nullptr;
-
-// we unfortunately have to build a map of hashes in case there is a
-// collision to verify our dev-id
-boost::container::flat_map<uint8_t, std::pair<uint8_t, uint8_t>> deviceHashes;
-
 void registerStorageFunctions() __attribute__((constructor));
-static sdbusplus::bus::bus dbus(ipmid_get_sd_bus_connection());
 
-bool writeFru()
+// An explicit FRU write transaction, opened with the OEM Begin FRU Write
+// command. Writes to the device are staged in image and only pushed, in
+// one WriteFru call, on commit; reads see the staged data. Without one,
+// Write FRU Data keeps guessing the end of the image or waiting on
+// cacheTimer. The device's bus and address are kept from Begin, as device
+// ids are reassigned whenever another device is loaded into the cache. A
+// transaction left idle for fruTransactionTimeoutSeconds is aborted.
+struct FruTransaction
 {
-    sdbusplus::message::message writeFru = dbus.new_method_call(
-        fruDeviceServiceName, "/xyz/openbmc_project/FruDevice",
-        "xyz.openbmc_project.FruDeviceManager", "WriteFru");
-    writeFru.append(cacheBus, cacheAddr, fruCache);
-    try
-    {
-        sdbusplus::message::message writeFruResp = dbus.call(writeFru);
-    }
-    catch (sdbusplus::exception_t&)
-    {
-        // todo: log sel?
-        phosphor::logging::log<phosphor::logging::level::ERR>(
-            "error writing fru");
-        return false;
-    }
-    return true;
+    bool active = false;
+    uint8_t devId = 0xFF;
+    uint8_t bus = 0xFF;
+    uint8_t address = 0xFF;
+    std::vector<uint8_t> image;
+    std::chrono::steady_clock::time_point expiry;
+};
+static FruTransaction fruTransaction;
+static std::unique_ptr<phosphor::Timer> fruTransactionTimer = nullptr;
+
+static void expireFruTransaction()
+{
+    phosphor::logging::log<phosphor::logging::level::WARNING>(
+        "FRU write transaction timed out, aborting",
+        phosphor::logging::entry("DEVID=0x%02X", fruTransaction.devId));
+    fruTransaction = FruTransaction();
 }
 
-void createTimer()
+// (re)arms the expiry of the open transaction
+static void touchFruTransaction()
 {
-    if (cacheTimer == nullptr)
+    auto timeout = std::chrono::seconds(fruTransactionTimeoutSeconds);
+    fruTransaction.expiry = std::chrono::steady_clock::now() + timeout;
+    if (fruTransactionTimer == nullptr)
     {
-        cacheTimer = std::make_unique<phosphor::Timer>(writeFru);
+        fruTransactionTimer =
+            std::make_unique<phosphor::Timer>(expireFruTransaction);
     }
+    fruTransactionTimer->start(
+        std::chrono::duration_cast<std::chrono::microseconds>(timeout));
 }
 
-ipmi_ret_t replaceCacheFru(uint8_t devId)
+static void endFruTransaction()
 {
-    static uint8_t lastDevId = 0xFF;
-
-    bool timerRunning = (cacheTimer != nullptr) && !cacheTimer->isExpired();
-    if (lastDevId == devId && timerRunning)
-    {
-        return IPMI_CC_OK; // cache already up to date
-    }
-    // if timer is running, stop it and writeFru manually
-    else if (timerRunning)
-    {
-        cacheTimer->stop();
-        writeFru();
-    }
-
-    sdbusplus::message::message getObjects = dbus.new_method_call(
-        fruDeviceServiceName, "/", "org.freedesktop.DBus.ObjectManager",
-        "GetManagedObjects");
-    ManagedObjectType frus;
-    try
-    {
-        sdbusplus::message::message resp = dbus.call(getObjects);
-        resp.read(frus);
-    }
-    catch (sdbusplus::exception_t&)
-    {
-        phosphor::logging::log<phosphor::logging::level::ERR>(
-            "replaceCacheFru: error getting managed objects");
-        return IPMI_CC_RESPONSE_ERROR;
-    }
-
-    deviceHashes.clear();
-
-    // hash the object paths to create unique device id's. increment on
-    // collision
-    std::hash<std::string> hasher;
-    for (const auto& fru : frus)
-    {
-        auto fruIface = fru.second.find("xyz.openbmc_project.FruDevice");
-        if (fruIface == fru.second.end())
-        {
-            continue;
-        }
-
-        auto busFind = fruIface->second.find("BUS");
-        auto addrFind = fruIface->second.find("ADDRESS");
-        if (busFind == fruIface->second.end() ||
-            addrFind == fruIface->second.end())
-        {
-            phosphor::logging::log<phosphor::logging::level::INFO>(
-                "fru device missing Bus or Address",
-                phosphor::logging::entry("FRU=%s", fru.first.str.c_str()));
-            continue;
-        }
-
-        uint8_t fruBus =
-            sdbusplus::message::variant_ns::get<uint32_t>(busFind->second);
-        uint8_t fruAddr =
-            sdbusplus::message::variant_ns::get<uint32_t>(addrFind->second);
-
-        uint8_t fruHash = 0;
-        if (fruBus != 0 || fruAddr != 0)
-        {
-            fruHash = hasher(fru.first.str);
-            // can't be 0xFF based on spec, and 0 is reserved for baseboard
-            if (fruHash == 0 || fruHash == 0xFF)
-            {
-                fruHash = 1;
-            }
-        }
-        std::pair<uint8_t, uint8_t> newDev(fruBus, fruAddr);
-
-        bool emplacePassed = false;
-        while (!emplacePassed)
-        {
-            auto resp = deviceHashes.emplace(fruHash, newDev);
-            emplacePassed = resp.second;
-            if (!emplacePassed)
-            {
-                fruHash++;
-                // can't be 0xFF based on spec, and 0 is reserved for
-                // baseboard
-                if (fruHash == 0XFF)
-                {
-                    fruHash = 0x1;
-                }
-            }
-        }
-    }
-    auto deviceFind = deviceHashes.find(devId);
-    if (deviceFind == deviceHashes.end())
+    if (fruTransactionTimer != nullptr)
     {
-        return IPMI_CC_SENSOR_INVALID;
-    }
-
-    fruCache.clear();
-    sdbusplus::message::message getRawFru = dbus.new_method_call(
-        fruDeviceServiceName, "/xyz/openbmc_project/FruDevice",
-        "xyz.openbmc_project.FruDeviceManager", "GetRawFru");
-    cacheBus = deviceFind->second.first;
-    cacheAddr = deviceFind->second.second;
-    getRawFru.append(cacheBus, cacheAddr);
-    try
-    {
-        sdbusplus::message::message getRawResp = dbus.call(getRawFru);
-        getRawResp.read(fruCache);
-    }
-    catch (sdbusplus::exception_t&)
-    {
-        lastDevId = 0xFF;
-        cacheBus = 0xFF;
-        cacheAddr = 0xFF;
-        return IPMI_CC_RESPONSE_ERROR;
+        fruTransactionTimer->stop();
     }
+    fruTransaction = FruTransaction();
+}
 
-    lastDevId = devId;
-    return IPMI_CC_OK;
+static bool inFruTransaction(uint8_t devId)
+{
+    return fruTransaction.active && fruTransaction.devId == devId;
 }
 
 ipmi_ret_t ipmiStorageReadFRUData(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
@@ -276,27 +167,32 @@ ipmi_ret_t ipmiStorageReadFRUData(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     {
         return IPMI_CC_INVALID_FIELD_REQUEST;
     }
-    ipmi_ret_t status = replaceCacheFru(req->fruDeviceID);
-
-    if (status != IPMI_CC_OK)
+    const std::vector<uint8_t>* fru = &fruTransaction.image;
+    if (!inFruTransaction(req->fruDeviceID))
     {
-        return status;
+        ipmi_ret_t status = replaceCacheFru(req->fruDeviceID);
+
+        if (status != IPMI_CC_OK)
+        {
+            return status;
+        }
+        fru = &fruCache;
     }
 
     size_t fromFRUByteLen = 0;
-    if (req->countToRead + req->fruInventoryOffset < fruCache.size())
+    if (req->countToRead + req->fruInventoryOffset < fru->size())
     {
         fromFRUByteLen = req->countToRead;
     }
-    else if (fruCache.size() > req->fruInventoryOffset)
+    else if (fru->size() > req->fruInventoryOffset)
     {
-        fromFRUByteLen = fruCache.size() - req->fruInventoryOffset;
+        fromFRUByteLen = fru->size() - req->fruInventoryOffset;
     }
     size_t padByteLen = req->countToRead - fromFRUByteLen;
     uint8_t* respPtr = static_cast<uint8_t*>(response);
     *respPtr = req->countToRead;
-    std::copy(fruCache.begin() + req->fruInventoryOffset,
-              fruCache.begin() + req->fruInventoryOffset + fromFRUByteLen,
+    std::copy(fru->begin() + req->fruInventoryOffset,
+              fru->begin() + req->fruInventoryOffset + fromFRUByteLen,
               ++respPtr);
     // if longer than the fru is requested, fill with 0xFF
     if (padByteLen)
@@ -328,6 +224,21 @@ ipmi_ret_t ipmiStorageWriteFRUData(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     size_t writeLen = *dataLen - 3;
     *dataLen = 0; // default to 0 in case of an error
 
+    if (inFruTransaction(req->fruDeviceID))
+    {
+        std::vector<uint8_t>& image = fruTransaction.image;
+        if (image.size() < req->fruInventoryOffset + writeLen)
+        {
+            image.resize(req->fruInventoryOffset + writeLen);
+        }
+        std::copy(req->data, req->data + writeLen,
+                  image.begin() + req->fruInventoryOffset);
+        touchFruTransaction();
+        *static_cast<uint8_t*>(response) = writeLen;
+        *dataLen = 1;
+        return IPMI_CC_OK;
+    }
+
     ipmi_ret_t status = replaceCacheFru(req->fruDeviceID);
     if (status != IPMI_CC_OK)
     {
@@ -342,34 +253,9 @@ ipmi_ret_t ipmiStorageWriteFRUData(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     std::copy(req->data, req->data + writeLen,
               fruCache.begin() + req->fruInventoryOffset);
 
-    bool atEnd = false;
-
-    if (fruCache.size() >= sizeof(FRUHeader))
-    {
-
-        FRUHeader* header = reinterpret_cast<FRUHeader*>(fruCache.data());
-
-        int lastRecordStart = std::max(
-            header->internalOffset,
-            std::max(header->chassisOffset,
-                     std::max(header->boardOffset, header->productOffset)));
-        // TODO: Handle Multi-Record FRUs?
-
-        lastRecordStart *= 8; // header starts in are multiples of 8 bytes
-
-        // get the length of the area in multiples of 8 bytes
-        if (lastWriteAddr > (lastRecordStart + 1))
-        {
-            // second byte in record area is the length
-            int areaLength(fruCache[lastRecordStart + 1]);
-            areaLength *= 8; // it is in multiples of 8 bytes
+    std::optional<size_t> fruEnd = getFruDataEnd(fruCache, lastWriteAddr);
+    bool atEnd = fruEnd && static_cast<size_t>(lastWriteAddr) >= *fruEnd;
 
-            if (lastWriteAddr >= (areaLength + lastRecordStart))
-            {
-                atEnd = true;
-            }
-        }
-    }
     uint8_t* respPtr = static_cast<uint8_t*>(response);
     if (atEnd)
     {
@@ -414,139 +300,134 @@ ipmi_ret_t ipmiStorageGetFRUInvAreaInfo(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     {
         return IPMI_CC_INVALID_FIELD_REQUEST;
     }
-    ipmi_ret_t status = replaceCacheFru(reqDev);
-
-    if (status != IPMI_CC_OK)
+    const std::vector<uint8_t>* fru = &fruTransaction.image;
+    if (!inFruTransaction(reqDev))
     {
-        return status;
+        ipmi_ret_t status = replaceCacheFru(reqDev);
+
+        if (status != IPMI_CC_OK)
+        {
+            return status;
+        }
+        fru = &fruCache;
     }
 
     GetFRUAreaResp* respPtr = static_cast<GetFRUAreaResp*>(response);
-    respPtr->inventorySizeLSB = fruCache.size() & 0xFF;
-    respPtr->inventorySizeMSB = fruCache.size() >> 8;
+    respPtr->inventorySizeLSB = fru->size() & 0xFF;
+    respPtr->inventorySizeMSB = fru->size() >> 8;
     respPtr->accessType = static_cast<uint8_t>(GetFRUAreaAccessType::byte);
 
     *dataLen = sizeof(GetFRUAreaResp);
     return IPMI_CC_OK;
 }
 
-ipmi_ret_t getFruSdrCount(size_t& count)
+ipmi::RspType<> ipmiStorageBeginFruWrite(uint8_t devId)
 {
-    ipmi_ret_t ret = replaceCacheFru(0);
-    if (ret != IPMI_CC_OK)
+    if (devId == 0xFF)
     {
-        return ret;
+        return ipmi::responseInvalidFieldRequest();
     }
-    count = deviceHashes.size();
-    return IPMI_CC_OK;
-}
-
-ipmi_ret_t getFruSdrs(size_t index, get_sdr::SensorDataFruRecord& resp)
-{
-    ipmi_ret_t ret = replaceCacheFru(0); // this will update the hash list
-    if (ret != IPMI_CC_OK)
+    // the timer can't fire while the event loop is held up, so an expired
+    // transaction is also dropped here
+    if (fruTransaction.active &&
+        std::chrono::steady_clock::now() >= fruTransaction.expiry)
     {
-        return ret;
+        if (fruTransactionTimer != nullptr)
+        {
+            fruTransactionTimer->stop();
+        }
+        expireFruTransaction();
     }
-    if (deviceHashes.size() < index)
+    if (fruTransaction.active && fruTransaction.devId != devId)
     {
-        return IPMI_CC_INVALID_FIELD_REQUEST;
+        return ipmi::responseBusy();
     }
-    auto device = deviceHashes.begin() + index;
-    uint8_t& bus = device->second.first;
-    uint8_t& address = device->second.second;
-
-    ManagedObjectType frus;
 
-    sdbusplus::message::message getObjects = dbus.new_method_call(
-        fruDeviceServiceName, "/", "org.freedesktop.DBus.ObjectManager",
-        "GetManagedObjects");
-    try
+    // a Write FRU Data image still waiting on the timer goes out first, so
+    // it can't land on top of the commit
+    if (cacheTimer != nullptr && !cacheTimer->isExpired())
     {
-        sdbusplus::message::message resp = dbus.call(getObjects);
-        resp.read(frus);
+        cacheTimer->stop();
+        writeFru();
     }
-    catch (sdbusplus::exception_t&)
+    ipmi_ret_t status = replaceCacheFru(devId);
+    if (status != IPMI_CC_OK)
     {
-        return IPMI_CC_RESPONSE_ERROR;
+        return ipmi::response(status);
     }
-    boost::container::flat_map<std::string, DbusVariant>* fruData = nullptr;
-    auto fru =
-        std::find_if(frus.begin(), frus.end(),
-                     [bus, address, &fruData](ManagedEntry& entry) {
-                         auto findFruDevice =
-                             entry.second.find("xyz.openbmc_project.FruDevice");
-                         if (findFruDevice == entry.second.end())
-                         {
-                             return false;
-                         }
-                         fruData = &(findFruDevice->second);
-                         auto findBus = findFruDevice->second.find("BUS");
-                         auto findAddress =
-                             findFruDevice->second.find("ADDRESS");
-                         if (findBus == findFruDevice->second.end() ||
-                             findAddress == findFruDevice->second.end())
-                         {
-                             return false;
-                         }
-                         if (sdbusplus::message::variant_ns::get<uint32_t>(
-                                 findBus->second) != bus)
-                         {
-                             return false;
-                         }
-                         if (sdbusplus::message::variant_ns::get<uint32_t>(
-                                 findAddress->second) != address)
-                         {
-                             return false;
-                         }
-                         return true;
-                     });
-    if (fru == frus.end())
+
+    // beginning again on the same device starts over
+    fruTransaction.active = true;
+    fruTransaction.devId = devId;
+    std::tie(fruTransaction.bus, fruTransaction.address) =
+        getCacheFruAddress();
+    fruTransaction.image = fruCache;
+    touchFruTransaction();
+    return ipmi::responseSuccess();
+}
+
+ipmi::RspType<> ipmiStorageCommitFruWrite(uint8_t devId)
+{
+    if (!inFruTransaction(devId))
     {
-        return IPMI_CC_RESPONSE_ERROR;
+        return ipmi::responseCommandNotAvailable();
     }
-    std::string name;
-    auto findProductName = fruData->find("BOARD_PRODUCT_NAME");
-    auto findBoardName = fruData->find("PRODUCT_PRODUCT_NAME");
-    if (findProductName != fruData->end())
+    // the transaction stays open on failure, so the host can fix the image
+    // and commit again, or abort
+    if (!checkFruChecksums(fruTransaction.image))
     {
-        name = sdbusplus::message::variant_ns::get<std::string>(
-            findProductName->second);
+        return ipmi::responseInvalidFieldRequest();
     }
-    else if (findBoardName != fruData->end())
+    ipmi_ret_t status = writeFruImage(
+        fruTransaction.bus, fruTransaction.address, fruTransaction.image);
+    if (status != IPMI_CC_OK)
     {
-        name = sdbusplus::message::variant_ns::get<std::string>(
-            findBoardName->second);
+        touchFruTransaction();
+        return ipmi::response(status);
     }
-    else
+
+    endFruTransaction();
+    return ipmi::responseSuccess();
+}
+
+ipmi::RspType<> ipmiStorageAbortFruWrite(uint8_t devId)
+{
+    if (!inFruTransaction(devId))
+    {
+        return ipmi::responseCommandNotAvailable();
+    }
+    endFruTransaction();
+    return ipmi::responseSuccess();
+}
+
+// fires the sel_scan_start/sel_scan_end probes around a SEL journal scan,
+// including scans that bail out early on a bad entry
+struct SelScanProbe
+{
+    explicit SelScanProbe(ipmi_cmd_t cmd) : cmd(cmd)
     {
-        name = "UNKNOWN";
+        IPMI_PROBE1(sel_scan_start, cmd);
     }
-    if (name.size() > maxFruSdrNameSize)
+
+    ~SelScanProbe()
     {
-        name = name.substr(0, maxFruSdrNameSize);
+        IPMI_PROBE2(sel_scan_end, cmd, entries);
     }
-    size_t sizeDiff = maxFruSdrNameSize - name.size();
-
-    resp.header.record_id_lsb = 0x0; // calling code is to implement these
-    resp.header.record_id_msb = 0x0;
-    resp.header.sdr_version = ipmiSdrVersion;
-    resp.header.record_type = 0x11; // FRU Device Locator
-    resp.header.record_length = sizeof(resp.body) + sizeof(resp.key) - sizeDiff;
-    resp.key.deviceAddress = 0x20;
-    resp.key.fruID = device->first;
-    resp.key.accessLun = 0x80; // logical / physical fru device
-    resp.key.channelNumber = 0x0;
-    resp.body.reserved = 0x0;
-    resp.body.deviceType = 0x10;
-    resp.body.deviceTypeModifier = 0x0;
-    resp.body.entityID = 0x0;
-    resp.body.entityInstance = 0x1;
-    resp.body.oem = 0x0;
-    resp.body.deviceIDLen = name.size();
-    name.copy(resp.body.deviceID, name.size());
 
-    return IPMI_CC_OK;
+    ipmi_cmd_t cmd;
+    size_t entries = 0;
+};
+
+// the SEL namespace only holds SEL entries, but they're still matched on
+// MESSAGE_ID so the same scans work against the system journal
+static int openSelJournal(sd_journal** journal)
+{
+#ifdef SEL_JOURNAL_NAMESPACE
+    return sd_journal_open_namespace(journal, SEL_JOURNAL_NAMESPACE,
+                                     SD_JOURNAL_LOCAL_ONLY);
+#else
+    return sd_journal_open(journal, SD_JOURNAL_LOCAL_ONLY);
+#endif
 }
 
 ipmi_ret_t ipmiStorageGetSELInfo(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
@@ -573,7 +454,7 @@ ipmi_ret_t ipmiStorageGetSELInfo(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
 
     // Open the journal
     sd_journal* journalTmp = nullptr;
-    if (int ret = sd_journal_open(&journalTmp, SD_JOURNAL_LOCAL_ONLY); ret < 0)
+    if (int ret = openSelJournal(&journalTmp); ret < 0)
     {
         phosphor::logging::log<phosphor::logging::level::ERR>(
             "Failed to open journal: ",
@@ -588,12 +469,14 @@ ipmi_ret_t ipmiStorageGetSELInfo(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     std::string match =
         "MESSAGE_ID=" + std::string(intel_oem::ipmi::sel::selMessageId);
     sd_journal_add_match(journal.get(), match.c_str(), 0);
+    SelScanProbe scan(cmd);
 
     // Count the number of SEL Entries in the journal and get the timestamp of
     // the newest entry
     bool timestampRecorded = false;
     SD_JOURNAL_FOREACH_BACKWARDS(journal.get())
     {
+        scan.entries++;
         if (!timestampRecorded)
         {
             uint64_t timestamp;
@@ -617,29 +500,6 @@ ipmi_ret_t ipmiStorageGetSELInfo(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     return IPMI_CC_OK;
 }
 
-static int fromHexStr(const std::string hexStr, std::vector<uint8_t>& data)
-{
-    for (unsigned int i = 0; i < hexStr.size(); i += 2)
-    {
-        try
-        {
-            data.push_back(static_cast<uint8_t>(
-                std::stoul(hexStr.substr(i, 2), nullptr, 16)));
-        }
-        catch (std::invalid_argument& e)
-        {
-            phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
-            return -1;
-        }
-        catch (std::out_of_range& e)
-        {
-            phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
-            return -1;
-        }
-    }
-    return 0;
-}
-
 static int getJournalMetadata(sd_journal* journal,
                               const std::string_view& field,
                               std::string& contents)
@@ -654,10 +514,9 @@ static int getJournalMetadata(sd_journal* journal,
     {
         return ret;
     }
-    std::string_view metadata(data, length);
     // Only use the content after the "=" character.
-    metadata.remove_prefix(std::min(metadata.find("=") + 1, metadata.size()));
-    contents = std::string(metadata);
+    contents = std::string(intel_oem::ipmi::sel::getJournalFieldValue(
+        std::string_view(data, length)));
     return 0;
 }
 
@@ -671,21 +530,7 @@ static int getJournalMetadata(sd_journal* journal,
     {
         return ret;
     }
-    try
-    {
-        contents = static_cast<int>(std::stoul(metadata, nullptr, base));
-    }
-    catch (std::invalid_argument& e)
-    {
-        phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
-        return -1;
-    }
-    catch (std::out_of_range& e)
-    {
-        phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
-        return -1;
-    }
-    return 0;
+    return intel_oem::ipmi::sel::parseJournalInt(metadata, base, contents);
 }
 
 static int getJournalSelData(sd_journal* journal, std::vector<uint8_t>& evtData)
@@ -697,7 +542,7 @@ static int getJournalSelData(sd_journal* journal, std::vector<uint8_t>& evtData)
     {
         return ret;
     }
-    return fromHexStr(evtDataStr, evtData);
+    return intel_oem::ipmi::sel::fromHexStr(evtDataStr, evtData);
 }
 
 ipmi_ret_t ipmiStorageGetSELEntry(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
@@ -729,7 +574,7 @@ ipmi_ret_t ipmiStorageGetSELEntry(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
 
     // Check for the requested SEL Entry.
     sd_journal* journalTmp;
-    if (int ret = sd_journal_open(&journalTmp, SD_JOURNAL_LOCAL_ONLY); ret < 0)
+    if (int ret = openSelJournal(&journalTmp); ret < 0)
     {
         phosphor::logging::log<phosphor::logging::level::ERR>(
             "Failed to open journal: ",
@@ -743,6 +588,7 @@ ipmi_ret_t ipmiStorageGetSELEntry(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     std::string match =
         "MESSAGE_ID=" + std::string(intel_oem::ipmi::sel::selMessageId);
     sd_journal_add_match(journal.get(), match.c_str(), 0);
+    SelScanProbe scan(cmd);
 
     // Get the requested target SEL record ID if first or last is requested.
     int targetID = requestData->selRecordID;
@@ -750,6 +596,7 @@ ipmi_ret_t ipmiStorageGetSELEntry(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     {
         SD_JOURNAL_FOREACH(journal.get())
         {
+            scan.entries++;
             // Get the record ID from the IPMI_SEL_RECORD_ID field of the first
             // entry
             if (getJournalMetadata(journal.get(), "IPMI_SEL_RECORD_ID", 10,
@@ -764,6 +611,7 @@ ipmi_ret_t ipmiStorageGetSELEntry(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     {
         SD_JOURNAL_FOREACH_BACKWARDS(journal.get())
         {
+            scan.entries++;
             // Get the record ID from the IPMI_SEL_RECORD_ID field of the first
             // entry
             if (getJournalMetadata(journal.get(), "IPMI_SEL_RECORD_ID", 10,
@@ -787,6 +635,7 @@ ipmi_ret_t ipmiStorageGetSELEntry(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     sd_journal_add_match(journal.get(), match.c_str(), 0);
     SD_JOURNAL_FOREACH(journal.get())
     {
+        scan.entries++;
         // Get the record ID from the IPMI_SEL_RECORD_ID field
         int id = 0;
         if (getJournalMetadata(journal.get(), "IPMI_SEL_RECORD_ID", 10, id) < 0)
@@ -992,7 +841,8 @@ ipmi_ret_t ipmiStorageAddSELEntry(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                         genId);
         try
         {
-            sdbusplus::message::message writeSELResp = bus.call(writeSEL);
+            sdbusplus::message::message writeSELResp =
+                accounting::call(bus, writeSEL);
             writeSELResp.read(recordID);
         }
         catch (sdbusplus::exception_t& e)
@@ -1024,7 +874,8 @@ ipmi_ret_t ipmiStorageAddSELEntry(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         writeSEL.append(ipmiSELAddMessage, eventData, req->recordType);
         try
         {
-            sdbusplus::message::message writeSELResp = bus.call(writeSEL);
+            sdbusplus::message::message writeSELResp =
+                accounting::call(bus, writeSEL);
             writeSELResp.read(recordID);
         }
         catch (sdbusplus::exception_t& e)
@@ -1090,6 +941,21 @@ ipmi_ret_t ipmiStorageClearSEL(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
 
     // Clear the SEL by by rotating the journal to start a new file then
     // vacuuming to keep only the new file
+#ifdef SEL_JOURNAL_NAMESPACE
+    // only the SEL namespace, the rest of the system journal is left alone
+    const std::string selNamespace =
+        std::string("--namespace=") + SEL_JOURNAL_NAMESPACE;
+    if (boost::process::system("/bin/journalctl", selNamespace, "--rotate") !=
+        0)
+    {
+        return IPMI_CC_UNSPECIFIED_ERROR;
+    }
+    if (boost::process::system("/bin/journalctl", selNamespace,
+                               "--vacuum-files=1") != 0)
+    {
+        return IPMI_CC_UNSPECIFIED_ERROR;
+    }
+#else
     if (boost::process::system("/bin/journalctl", "--rotate") != 0)
     {
         return IPMI_CC_UNSPECIFIED_ERROR;
@@ -1098,6 +964,7 @@ ipmi_ret_t ipmiStorageClearSEL(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     {
         return IPMI_CC_UNSPECIFIED_ERROR;
     }
+#endif
 
     *static_cast<uint8_t*>(response) = eraseProgress;
     *data_len = sizeof(eraseProgress);
@@ -1135,6 +1002,24 @@ void registerStorageFunctions()
         static_cast<ipmi_cmd_t>(IPMINetfnStorageCmds::ipmiCmdWriteFRUData),
         NULL, ipmiStorageWriteFRUData, PRIVILEGE_OPERATOR);
 
+    // <Begin FRU Write>
+    ipmi::registerTimedHandler(
+        ipmi::prioOemBase, netfnIntcOEMGeneral,
+        static_cast<ipmi::Cmd>(IPMINetfnIntelOEMGeneralCmd::cmdBeginFruWrite),
+        ipmi::Privilege::Operator, ipmiStorageBeginFruWrite);
+
+    // <Commit FRU Write>
+    ipmi::registerTimedHandler(
+        ipmi::prioOemBase, netfnIntcOEMGeneral,
+        static_cast<ipmi::Cmd>(IPMINetfnIntelOEMGeneralCmd::cmdCommitFruWrite),
+        ipmi::Privilege::Operator, ipmiStorageCommitFruWrite);
+
+    // <Abort FRU Write>
+    ipmi::registerTimedHandler(
+        ipmi::prioOemBase, netfnIntcOEMGeneral,
+        static_cast<ipmi::Cmd>(IPMINetfnIntelOEMGeneralCmd::cmdAbortFruWrite),
+        ipmi::Privilege::Operator, ipmiStorageAbortFruWrite);
+
     // <Get SEL Info>
     ipmiPrintAndRegister(
         NETFUN_STORAGE,
@@ -0,0 +1,126 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <chrono>
+#include <dbusaccounting.hpp>
+#include <deque>
+#include <map>
+#include <memory>
+#include <phosphor-logging/log.hpp>
+#include <sdbusplus/timer.hpp>
+#include <vector>
+#include <writebehind.hpp>
+
+namespace ipmi
+{
+namespace writebehind
+{
+struct Write
+{
+    sdbusplus::bus::bus* bus;
+    std::string path;
+    std::string interface;
+    std::string property;
+    Value value;
+};
+
+static std::deque<Write> writes;
+static std::unique_ptr<phosphor::Timer> applyTimer;
+
+// the mapper lookup of ipmi::getService, without needing libipmid here
+static std::string getService(sdbusplus::bus::bus& bus,
+                              const std::string& path,
+                              const std::string& interface)
+{
+    auto getObject = bus.new_method_call(
+        accounting::mapperService, "/xyz/openbmc_project/object_mapper",
+        "xyz.openbmc_project.ObjectMapper", "GetObject");
+    getObject.append(path, std::vector<std::string>{interface});
+    auto reply = accounting::call(bus, getObject);
+    std::map<std::string, std::vector<std::string>> services;
+    reply.read(services);
+    return services.empty() ? std::string() : services.begin()->first;
+}
+
+static void apply(const Write& write)
+{
+    try
+    {
+        std::string service =
+            getService(*write.bus, write.path, write.interface);
+        auto set = write.bus->new_method_call(
+            service.c_str(), write.path.c_str(),
+            "org.freedesktop.DBus.Properties", "Set");
+        set.append(write.interface, write.property, write.value);
+        accounting::call(*write.bus, set);
+    }
+    catch (sdbusplus::exception_t& e)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Failed to apply queued property write",
+            phosphor::logging::entry("PATH=%s", write.path.c_str()),
+            phosphor::logging::entry("INTERFACE=%s", write.interface.c_str()),
+            phosphor::logging::entry("PROPERTY=%s", write.property.c_str()),
+            phosphor::logging::entry("ERR=%s", e.what()));
+    }
+}
+
+void queue(sdbusplus::bus::bus& bus, const std::string& path,
+           const std::string& interface, const std::string& property,
+           const Value& value)
+{
+    writes.push_back({&bus, path, interface, property, value});
+    if (applyTimer == nullptr)
+    {
+        applyTimer = std::make_unique<phosphor::Timer>(flush);
+    }
+    if (!applyTimer->isRunning())
+    {
+        // fires on the next pass of the event loop, after the reply is sent
+        applyTimer->start(std::chrono::microseconds(0));
+    }
+}
+
+std::optional<Value> pending(const std::string& path,
+                             const std::string& interface,
+                             const std::string& property)
+{
+    for (auto write = writes.rbegin(); write != writes.rend(); write++)
+    {
+        if (write->property == property && write->path == path &&
+            write->interface == interface)
+        {
+            return write->value;
+        }
+    }
+    return std::nullopt;
+}
+
+void flush()
+{
+    if (applyTimer != nullptr)
+    {
+        applyTimer->stop();
+    }
+    // a write stays visible to pending() until it has been applied
+    while (!writes.empty())
+    {
+        apply(writes.front());
+        writes.pop_front();
+    }
+}
+} // namespace writebehind
+} // namespace ipmi
@@ -0,0 +1,665 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "dbusfixture.hpp"
+
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <sdbusplus/exception.hpp>
+#include <stdexcept>
+#include <systemd/sd-bus.h>
+#include <utility>
+
+namespace ipmi
+{
+namespace test
+{
+static constexpr const char* mapperService = "xyz.openbmc_project.ObjectMapper";
+static constexpr const char* mapperPath = "/xyz/openbmc_project/object_mapper";
+static constexpr const char* fruService = "xyz.openbmc_project.FruDevice";
+static constexpr const char* fruManagerPath = "/xyz/openbmc_project/FruDevice";
+static constexpr const char* entityManagerService =
+    "xyz.openbmc_project.EntityManager";
+static constexpr const char* pidIntf = "xyz.openbmc_project.Configuration.Pid";
+static constexpr const char* settingsService = "xyz.openbmc_project.Settings";
+static constexpr const char* exitAirService =
+    "xyz.openbmc_project.ExitAirTempSensor";
+static constexpr const char* selService = "xyz.openbmc_project.Logging.IPMI";
+static constexpr const char* selPath = "/xyz/openbmc_project/Logging/IPMI";
+
+static constexpr const char* valueIntf = "xyz.openbmc_project.Sensor.Value";
+static constexpr const char* warningIntf =
+    "xyz.openbmc_project.Sensor.Threshold.Warning";
+static constexpr const char* criticalIntf =
+    "xyz.openbmc_project.Sensor.Threshold.Critical";
+static constexpr const char* statusIntf =
+    "xyz.openbmc_project.State.Decorator.OperationalStatus";
+
+struct SensorKind
+{
+    const char* type;
+    const char* service;
+    const char* prefix;
+    double minValue;
+    double maxValue;
+    double nominal;
+};
+
+// weighted roughly like a two socket server: mostly temperatures and rails
+static constexpr std::array<SensorKind, 5> sensorKinds = {{
+    {"temperature", "xyz.openbmc_project.HwmonTempSensor", "Temp", -128, 127,
+     40},
+    {"voltage", "xyz.openbmc_project.ADCSensor", "Volt", 0, 16, 3.3},
+    {"fan_tach", "xyz.openbmc_project.FanSensor", "Fan", 0, 25000, 8000},
+    {"power", "xyz.openbmc_project.PSUSensor", "Power", 0, 3000, 450},
+    {"current", "xyz.openbmc_project.PSUSensor", "Curr", 0, 255, 12},
+}};
+
+std::vector<uint8_t> makeFruData(const std::string& productName)
+{
+    static constexpr const char* manufacturer = "Intel Corporation";
+    static constexpr const char* serial = "0000000000";
+
+    auto appendField = [](std::vector<uint8_t>& area, const std::string& str) {
+        // 8 bit ascii, length in the low 6 bits
+        size_t length = std::min<size_t>(str.size(), 0x3F);
+        area.push_back(0xC0 | length);
+        area.insert(area.end(), str.begin(), str.begin() + length);
+    };
+    auto checksum = [](const std::vector<uint8_t>& data, size_t begin) {
+        uint8_t sum = std::accumulate(data.begin() + begin, data.end(), 0);
+        return static_cast<uint8_t>(-sum);
+    };
+
+    std::vector<uint8_t> board = {0x01, 0x00, 0x19, 0x00, 0x00, 0x00};
+    appendField(board, manufacturer);
+    appendField(board, productName);
+    appendField(board, serial);
+    appendField(board, ""); // part number
+    appendField(board, ""); // fru file id
+    board.push_back(0xC1); // end of fields
+    while ((board.size() + 1) % 8)
+    {
+        board.push_back(0);
+    }
+    board[1] = (board.size() + 1) / 8;
+    board.push_back(checksum(board, 0));
+
+    // common header: only a board area, right after the header
+    std::vector<uint8_t> data = {0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00};
+    data.push_back(checksum(data, 0));
+    data.insert(data.end(), board.begin(), board.end());
+    return data;
+}
+
+Platform generatePlatform(size_t sensorCount, size_t fruCount)
+{
+    Platform platform;
+    sensorCount = std::clamp(sensorCount, minSensors, maxSensors);
+    fruCount = std::clamp(fruCount, minFrus, maxFrus);
+
+    std::array<size_t, sensorKinds.size()> indexes = {};
+    for (size_t ii = 0; ii < sensorCount; ii++)
+    {
+        size_t kindIndex = ii % sensorKinds.size();
+        const SensorKind& kind = sensorKinds[kindIndex];
+        size_t index = ++indexes[kindIndex];
+
+        FakeSensor sensor;
+        sensor.service = kind.service;
+        sensor.path = std::string("/xyz/openbmc_project/sensors/") +
+                      kind.type + "/" + kind.prefix + "_" +
+                      std::to_string(index);
+        sensor.minValue = kind.minValue;
+        sensor.maxValue = kind.maxValue;
+        // spread readings a little so the records are not all identical
+        sensor.value = kind.nominal * (1.0 + (index % 7) / 100.0);
+
+        double range = kind.maxValue - kind.minValue;
+        // every third sensor has no thresholds at all, like most rails
+        if (index % 3)
+        {
+            sensor.warningHigh = kind.nominal + range * 0.2;
+            sensor.criticalHigh = kind.nominal + range * 0.3;
+            if (kind.minValue >= 0)
+            {
+                sensor.warningLow = kind.nominal / 2;
+                sensor.criticalLow = kind.nominal / 4;
+            }
+        }
+        platform.sensors.emplace_back(std::move(sensor));
+    }
+
+    for (size_t ii = 0; ii < fruCount; ii++)
+    {
+        FakeFru fru;
+        if (ii == 0)
+        {
+            fru.productName = "Baseboard";
+            fru.bus = 0;
+            fru.address = 0;
+        }
+        else
+        {
+            fru.productName = "Fru_" + std::to_string(ii);
+            fru.bus = 1 + (ii - 1) / 8;
+            fru.address = 0x50 + (ii - 1) % 8;
+        }
+        fru.path = std::string(fruManagerPath) + "/" + fru.productName;
+        fru.data = makeFruData(fru.productName);
+        platform.frus.emplace_back(std::move(fru));
+    }
+
+    static constexpr const char* configPath =
+        "/xyz/openbmc_project/inventory/system/board/Baseboard/";
+    platform.pids.push_back(
+        {std::string(configPath) + "Exit_Air_Temp", "temp", 30, 100, 45});
+    for (size_t ii = 1; ii <= 4; ii++)
+    {
+        platform.pids.push_back({std::string(configPath) + "Fan_" +
+                                     std::to_string(ii),
+                                 "fan", 25, 100, 0});
+    }
+    return platform;
+}
+
+DbusDaemon::DbusDaemon()
+{
+    char dirTemplate[] = "/tmp/ipmi-dbus-XXXXXX";
+    if (mkdtemp(dirTemplate) == nullptr)
+    {
+        throw std::runtime_error("mkdtemp failed");
+    }
+    directory = dirTemplate;
+
+    std::string configFile = directory + "/bus.conf";
+    std::ofstream config(configFile);
+    config << "<!DOCTYPE busconfig PUBLIC "
+              "\"-//freedesktop//DTD D-Bus Bus Configuration 1.0//EN\" "
+              "\"http://www.freedesktop.org/standards/dbus/1.0/"
+              "busconfig.dtd\">\n"
+              "<busconfig>\n"
+              "  <type>system</type>\n"
+              "  <listen>unix:path="
+           << directory
+           << "/system_bus_socket</listen>\n"
+              "  <policy context=\"default\">\n"
+              "    <allow user=\"*\"/>\n"
+              "    <allow own=\"*\"/>\n"
+              "    <allow send_destination=\"*\" eavesdrop=\"true\"/>\n"
+              "    <allow eavesdrop=\"true\"/>\n"
+              "  </policy>\n"
+              "</busconfig>\n";
+    config.close();
+
+    std::array<int, 2> fds;
+    if (pipe(fds.data()) != 0)
+    {
+        throw std::runtime_error("pipe failed");
+    }
+
+    pid = fork();
+    if (pid < 0)
+    {
+        throw std::runtime_error("fork failed");
+    }
+    if (pid == 0)
+    {
+        close(fds[0]);
+        std::string configArg = "--config-file=" + configFile;
+        std::string addressArg = "--print-address=" + std::to_string(fds[1]);
+        execlp("dbus-daemon", "dbus-daemon", "--nofork", "--nopidfile",
+               configArg.c_str(), addressArg.c_str(), nullptr);
+        _exit(127);
+    }
+    close(fds[1]);
+
+    // the daemon prints its address once it is accepting connections
+    std::array<char, 512> buffer;
+    ssize_t length = 0;
+    while (length < static_cast<ssize_t>(buffer.size()))
+    {
+        ssize_t count =
+            read(fds[0], buffer.data() + length, buffer.size() - length);
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (count <= 0)
+        {
+            break;
+        }
+        length += count;
+        if (buffer[length - 1] == '\n')
+        {
+            break;
+        }
+    }
+    close(fds[0]);
+    if (length <= 1)
+    {
+        throw std::runtime_error("dbus-daemon failed to start");
+    }
+    busAddress.assign(buffer.data(), length - 1);
+    setenv("DBUS_SYSTEM_BUS_ADDRESS", busAddress.c_str(), 1);
+}
+
+DbusDaemon::~DbusDaemon()
+{
+    if (pid > 0)
+    {
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+    }
+    unsetenv("DBUS_SYSTEM_BUS_ADDRESS");
+    std::remove((directory + "/bus.conf").c_str());
+    std::remove((directory + "/system_bus_socket").c_str());
+    rmdir(directory.c_str());
+}
+
+static int countCall(sd_bus_message* m, void* userdata, sd_bus_error*)
+{
+    uint8_t type = 0;
+    if (sd_bus_message_get_type(m, &type) >= 0 &&
+        type == SD_BUS_MESSAGE_METHOD_CALL)
+    {
+        (*static_cast<std::atomic<size_t>*>(userdata))++;
+    }
+    return 0;
+}
+
+FakeServices::FakeServices(const Platform& platform) : platform(platform)
+{
+    addMapper();
+    addSensors();
+    addFruDevice();
+    addEntityManager();
+    addSettings();
+    addSelLogger();
+
+    // everything is registered before the thread starts, after that the
+    // service state is only touched from the handlers running on it. asio is
+    // built without thread support, so the io_context is never touched from
+    // another thread, not even to stop it.
+    thread = std::thread([this]() {
+        while (!stopping)
+        {
+            io.run_one_for(std::chrono::milliseconds(10));
+        }
+    });
+}
+
+FakeServices::~FakeServices()
+{
+    stopping = true;
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+    interfaces.clear();
+    servers.clear();
+    connections.clear();
+}
+
+std::vector<SelEntry> FakeServices::selEntries()
+{
+    std::lock_guard<std::mutex> lock(selLock);
+    return sel;
+}
+
+FakeServices::Connection FakeServices::addService(const std::string& name)
+{
+    sd_bus* bus = nullptr;
+    if (sd_bus_open_system(&bus) < 0)
+    {
+        throw std::runtime_error("Failed to connect to the test bus");
+    }
+    sd_bus_add_filter(bus, nullptr, countCall, &calls);
+
+    auto conn = std::make_shared<sdbusplus::asio::connection>(io, bus);
+    conn->request_name(name.c_str());
+    connections.push_back(conn);
+    servers.emplace_back(
+        std::make_unique<sdbusplus::asio::object_server>(conn));
+    return conn;
+}
+
+sdbusplus::asio::object_server&
+    FakeServices::serverFor(const Connection& conn)
+{
+    auto it = std::find(connections.begin(), connections.end(), conn);
+    return *servers[it - connections.begin()];
+}
+
+void FakeServices::addMapper()
+{
+    Connection conn = addService(mapperService);
+    auto iface = serverFor(conn).add_interface(
+        mapperPath, "xyz.openbmc_project.ObjectMapper");
+    interfaces.push_back(iface);
+
+    using ServiceMap = std::vector<std::pair<std::string,
+                                             std::vector<std::string>>>;
+
+    // services on a path implementing at least one of the interfaces, or all
+    // of them when no interface is given
+    auto filter = [this](const std::string& path,
+                         const std::vector<std::string>& wanted) {
+        ServiceMap services;
+        auto object = objects.find(path);
+        if (object == objects.end())
+        {
+            return services;
+        }
+        for (const auto& [service, intfs] : object->second)
+        {
+            bool match = wanted.empty() ||
+                         std::any_of(intfs.begin(), intfs.end(),
+                                     [&wanted](const std::string& intf) {
+                                         return std::find(wanted.begin(),
+                                                          wanted.end(),
+                                                          intf) !=
+                                                wanted.end();
+                                     });
+            if (match)
+            {
+                services.emplace_back(service, intfs);
+            }
+        }
+        return services;
+    };
+
+    iface->register_method(
+        "GetSubTree", [this, filter](const std::string& subtree, int32_t depth,
+                                     const std::vector<std::string>& wanted) {
+            std::vector<std::pair<std::string, ServiceMap>> ret;
+            std::string prefix = subtree == "/" ? "/" : subtree + "/";
+            size_t baseDepth = std::count(prefix.begin(), prefix.end(), '/');
+            for (const auto& object : objects)
+            {
+                const std::string& path = object.first;
+                if (path.compare(0, prefix.size(), prefix) != 0)
+                {
+                    continue;
+                }
+                size_t pathDepth =
+                    std::count(path.begin(), path.end(), '/') + 1 - baseDepth;
+                if (depth > 0 && pathDepth > static_cast<size_t>(depth))
+                {
+                    continue;
+                }
+                ServiceMap services = filter(path, wanted);
+                if (!services.empty())
+                {
+                    ret.emplace_back(path, std::move(services));
+                }
+            }
+            return ret;
+        });
+
+    iface->register_method(
+        "GetObject", [filter](const std::string& path,
+                              const std::vector<std::string>& wanted) {
+            ServiceMap services = filter(path, wanted);
+            if (services.empty())
+            {
+                throw sdbusplus::exception::SdBusError(-ENOENT, "GetObject");
+            }
+            return services;
+        });
+
+    iface->initialize();
+}
+
+void FakeServices::addSensors()
+{
+    boost::container::flat_map<std::string, Connection> services;
+    for (const FakeSensor& sensor : platform.sensors)
+    {
+        Connection& conn = services[sensor.service];
+        if (!conn)
+        {
+            conn = addService(sensor.service);
+        }
+        sdbusplus::asio::object_server& server = serverFor(conn);
+        std::vector<std::string>& intfs = objects[sensor.path][sensor.service];
+
+        auto value = server.add_interface(sensor.path, valueIntf);
+        value->register_property("Value", sensor.value);
+        value->register_property("MaxValue", sensor.maxValue);
+        value->register_property("MinValue", sensor.minValue);
+        value->initialize();
+        interfaces.push_back(value);
+        intfs.push_back(valueIntf);
+
+        // not read by the handlers, present like on real sensor services
+        auto status = server.add_interface(sensor.path, statusIntf);
+        status->register_property("Functional", true);
+        status->initialize();
+        interfaces.push_back(status);
+        intfs.push_back(statusIntf);
+
+        auto addThreshold = [&](const char* intf, const std::string& level,
+                                const std::optional<double>& low,
+                                const std::optional<double>& high) {
+            if (!low && !high)
+            {
+                return;
+            }
+            auto threshold = server.add_interface(sensor.path, intf);
+            if (high)
+            {
+                threshold->register_property(
+                    level + "High", *high,
+                    sdbusplus::asio::PropertyPermission::readWrite);
+                threshold->register_property(level + "AlarmHigh", false);
+            }
+            if (low)
+            {
+                threshold->register_property(
+                    level + "Low", *low,
+                    sdbusplus::asio::PropertyPermission::readWrite);
+                threshold->register_property(level + "AlarmLow", false);
+            }
+            threshold->initialize();
+            interfaces.push_back(threshold);
+            intfs.push_back(intf);
+        };
+        addThreshold(warningIntf, "Warning", sensor.warningLow,
+                     sensor.warningHigh);
+        addThreshold(criticalIntf, "Critical", sensor.criticalLow,
+                     sensor.criticalHigh);
+    }
+}
+
+void FakeServices::addFruDevice()
+{
+    Connection conn = addService(fruService);
+    sdbusplus::asio::object_server& server = serverFor(conn);
+
+    for (const FakeFru& fru : platform.frus)
+    {
+        auto iface = server.add_interface(fru.path, fruService);
+        iface->register_property("BUS", fru.bus);
+        iface->register_property("ADDRESS", fru.address);
+        iface->register_property("BOARD_PRODUCT_NAME", fru.productName);
+        iface->initialize();
+        interfaces.push_back(iface);
+        objects[fru.path][fruService].push_back(fruService);
+    }
+
+    auto findFru = [this](uint8_t bus, uint8_t address) {
+        auto fru = std::find_if(platform.frus.begin(), platform.frus.end(),
+                                [bus, address](const FakeFru& fru) {
+                                    return fru.bus == bus &&
+                                           fru.address == address;
+                                });
+        if (fru == platform.frus.end())
+        {
+            throw sdbusplus::exception::SdBusError(-ENOENT, "FruDevice");
+        }
+        return fru;
+    };
+
+    auto manager = server.add_interface(fruManagerPath,
+                                        "xyz.openbmc_project.FruDeviceManager");
+    manager->register_method("GetRawFru",
+                             [findFru](uint8_t bus, uint8_t address) {
+                                 return findFru(bus, address)->data;
+                             });
+    manager->register_method(
+        "WriteFru", [findFru](uint8_t bus, uint8_t address,
+                              const std::vector<uint8_t>& data) {
+            findFru(bus, address)->data = data;
+        });
+    manager->initialize();
+    interfaces.push_back(manager);
+}
+
+void FakeServices::addEntityManager()
+{
+    Connection conn = addService(entityManagerService);
+    sdbusplus::asio::object_server& server = serverFor(conn);
+
+    for (const FakePid& pid : platform.pids)
+    {
+        auto iface = server.add_interface(pid.path, pidIntf);
+        iface->register_property("Class", pid.pidClass);
+        iface->register_property(
+            "OutLimitMin", pid.outLimitMin,
+            sdbusplus::asio::PropertyPermission::readWrite);
+        iface->register_property(
+            "OutLimitMax", pid.outLimitMax,
+            sdbusplus::asio::PropertyPermission::readWrite);
+        iface->register_property(
+            "SetPoint", pid.setPoint,
+            sdbusplus::asio::PropertyPermission::readWrite);
+        iface->initialize();
+        interfaces.push_back(iface);
+        objects[pid.path][entityManagerService].push_back(pidIntf);
+    }
+}
+
+void FakeServices::addSettings()
+{
+    Connection conn = addService(settingsService);
+    sdbusplus::asio::object_server& server = serverFor(conn);
+
+    auto add = [this, &server](const std::string& path,
+                               const std::string& intf) {
+        auto iface = server.add_interface(path, intf);
+        interfaces.push_back(iface);
+        objects[path][settingsService].push_back(intf);
+        return iface;
+    };
+    constexpr auto readWrite = sdbusplus::asio::PropertyPermission::readWrite;
+
+    auto thermal = add("/xyz/openbmc_project/control/thermal_mode",
+                       "xyz.openbmc_project.Control.ThermalMode");
+    thermal->register_property("Current", std::string("Performance"),
+                               readWrite);
+    thermal->register_property(
+        "Supported",
+        std::vector<std::string>{"Acoustic", "Performance", "Custom"});
+    thermal->initialize();
+
+    auto cfm = add("/xyz/openbmc_project/control/cfm_limit",
+                   "xyz.openbmc_project.Control.CFMLimit");
+    cfm->register_property("Limit", 0.0, readWrite);
+    cfm->initialize();
+
+    auto restoreDelay = add("/xyz/openbmc_project/control/power_restore_delay",
+                            "xyz.openbmc_project.Control.Power.RestoreDelay");
+    restoreDelay->register_property("PowerRestoreDelay", uint16_t(0),
+                                    readWrite);
+    restoreDelay->initialize();
+
+    auto errConfig =
+        add("/xyz/openbmc_project/control/processor_error_config",
+            "xyz.openbmc_project.Control.Processor.ErrConfig");
+    errConfig->register_property("ResetCfg", uint8_t(0), readWrite);
+    errConfig->register_property("ResetErrorOccurrenceCounts", uint8_t(0),
+                                 readWrite);
+    errConfig->initialize();
+
+    auto shutdown = add("/xyz/openbmc_project/control/shutdown_policy_config",
+                        "xyz.openbmc_project.Control.ShutdownPolicy");
+    shutdown->register_property("Policy", uint8_t(0), readWrite);
+    shutdown->initialize();
+
+    auto guid = add("/xyz/openbmc_project/control/host0/systemGUID",
+                    "xyz.openbmc_project.Common.UUID");
+    guid->register_property("UUID", std::string(), readWrite);
+    guid->initialize();
+
+    auto bios = add("/xyz/openbmc_project/bios",
+                    "xyz.openbmc_project.Inventory.Item.Bios");
+    bios->register_property("BiosId", std::string(), readWrite);
+    bios->initialize();
+
+    // the exit air sensor publishes the CFM it can sustain
+    Connection exitAir = addService(exitAirService);
+    auto maxCfm = serverFor(exitAir).add_interface(
+        "/xyz/openbmc_project/control/MaxCFM",
+        "xyz.openbmc_project.Control.CFMLimit");
+    maxCfm->register_property("Limit", 50.0);
+    maxCfm->initialize();
+    interfaces.push_back(maxCfm);
+}
+
+void FakeServices::addSelLogger()
+{
+    Connection conn = addService(selService);
+    auto iface = serverFor(conn).add_interface(selPath, selService);
+    interfaces.push_back(iface);
+
+    iface->register_method(
+        "IpmiSelAdd",
+        [this](const std::string& message, const std::string& path,
+               const std::vector<uint8_t>& data, bool assert,
+               uint16_t generatorId) {
+            std::lock_guard<std::mutex> lock(selLock);
+            sel.push_back({message, path, data, assert, generatorId});
+            return static_cast<uint16_t>(sel.size());
+        });
+    iface->register_method(
+        "IpmiSelAddOem", [this](const std::string& message,
+                                const std::vector<uint8_t>& data,
+                                uint8_t recordType) {
+            std::lock_guard<std::mutex> lock(selLock);
+            sel.push_back({message, "", data, true, recordType});
+            return static_cast<uint16_t>(sel.size());
+        });
+    iface->initialize();
+}
+
+FakePlatform::FakePlatform(size_t sensorCount, size_t fruCount) :
+    description(generatePlatform(sensorCount, fruCount)),
+    fakes(std::make_unique<FakeServices>(description))
+{
+}
+} // namespace test
+} // namespace ipmi
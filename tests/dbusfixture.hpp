@@ -0,0 +1,200 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <sys/types.h>
+
+#include <atomic>
+#include <boost/asio/io_context.hpp>
+#include <boost/container/flat_map.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sdbusplus/asio/connection.hpp>
+#include <sdbusplus/asio/object_server.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Off-target test fixture: a private dbus-daemon plus in-process fakes of the
+// services the providers talk to (ObjectMapper, sensor daemons, FruDevice,
+// EntityManager PID configurations, settings and the IPMI SEL logger),
+// populated from a generated platform description.
+namespace ipmi
+{
+namespace test
+{
+struct FakeSensor
+{
+    std::string service;
+    std::string path;
+    double value;
+    double minValue;
+    double maxValue;
+    std::optional<double> warningLow;
+    std::optional<double> warningHigh;
+    std::optional<double> criticalLow;
+    std::optional<double> criticalHigh;
+};
+
+struct FakeFru
+{
+    std::string path;
+    uint32_t bus;
+    uint32_t address;
+    std::string productName;
+    std::vector<uint8_t> data;
+};
+
+struct FakePid
+{
+    std::string path;
+    std::string pidClass; // "fan" or "temp"
+    double outLimitMin;
+    double outLimitMax;
+    double setPoint;
+};
+
+struct Platform
+{
+    std::vector<FakeSensor> sensors;
+    std::vector<FakeFru> frus;
+    std::vector<FakePid> pids;
+};
+
+static constexpr const size_t minSensors = 10;
+static constexpr const size_t maxSensors = 2000;
+static constexpr const size_t minFrus = 1;
+static constexpr const size_t maxFrus = 128;
+
+// Deterministic for a given size: sensors are spread over the usual sensor
+// daemons and types, the first FRU is the baseboard at bus 0 address 0.
+// Counts outside of the supported range are clamped.
+Platform generatePlatform(size_t sensorCount, size_t fruCount);
+
+// minimal valid IPMI FRU image (common header plus board info area)
+std::vector<uint8_t> makeFruData(const std::string& productName);
+
+// Private system bus. DBUS_SYSTEM_BUS_ADDRESS is pointed at it for the life
+// of the object, so sd_bus_default_system() and friends connect to it.
+class DbusDaemon
+{
+  public:
+    DbusDaemon();
+    ~DbusDaemon();
+
+    DbusDaemon(const DbusDaemon&) = delete;
+    DbusDaemon& operator=(const DbusDaemon&) = delete;
+
+    const std::string& address() const
+    {
+        return busAddress;
+    }
+
+  private:
+    std::string directory;
+    std::string busAddress;
+    pid_t pid = -1;
+};
+
+struct SelEntry
+{
+    std::string message;
+    std::string path;
+    std::vector<uint8_t> data;
+    bool assert;
+    uint16_t generatorId;
+};
+
+// Hosts the fake services on their own connections and io_context, running
+// on a background thread so that handlers under test can make blocking calls.
+class FakeServices
+{
+  public:
+    FakeServices(const Platform& platform);
+    ~FakeServices();
+
+    FakeServices(const FakeServices&) = delete;
+    FakeServices& operator=(const FakeServices&) = delete;
+
+    // number of method calls received by all fakes, including property and
+    // object manager calls
+    size_t callCount() const
+    {
+        return calls;
+    }
+
+    // SEL entries received by the fake IPMI logging service
+    std::vector<SelEntry> selEntries();
+
+  private:
+    using Connection = std::shared_ptr<sdbusplus::asio::connection>;
+
+    Connection addService(const std::string& name);
+    sdbusplus::asio::object_server& serverFor(const Connection& conn);
+
+    void addMapper();
+    void addSensors();
+    void addFruDevice();
+    void addEntityManager();
+    void addSettings();
+    void addSelLogger();
+
+    Platform platform;
+    boost::asio::io_context io;
+    std::vector<Connection> connections;
+    std::vector<std::unique_ptr<sdbusplus::asio::object_server>> servers;
+    std::vector<std::shared_ptr<sdbusplus::asio::dbus_interface>> interfaces;
+
+    // path -> service -> interfaces, answered by the fake mapper
+    boost::container::flat_map<
+        std::string,
+        boost::container::flat_map<std::string, std::vector<std::string>>>
+        objects;
+
+    std::atomic<bool> stopping{false};
+    std::atomic<size_t> calls{0};
+    std::mutex selLock;
+    std::vector<SelEntry> sel;
+    std::thread thread;
+};
+
+// Everything a handler test needs: the private bus and a generated platform
+// served on it.
+class FakePlatform
+{
+  public:
+    FakePlatform(size_t sensorCount, size_t fruCount);
+
+    const Platform& platform() const
+    {
+        return description;
+    }
+
+    FakeServices& services()
+    {
+        return *fakes;
+    }
+
+  private:
+    DbusDaemon daemon;
+    Platform description;
+    std::unique_ptr<FakeServices> fakes;
+};
+} // namespace test
+} // namespace ipmi
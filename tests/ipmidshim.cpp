@@ -0,0 +1,167 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "ipmidshim.hpp"
+
+#include <dlfcn.h>
+
+#include <array>
+#include <boost/container/flat_map.hpp>
+#include <iostream>
+#include <ipmid/api.hpp>
+#include <ipmid/handler.hpp>
+#include <ipmid/message.hpp>
+
+namespace
+{
+struct Registration
+{
+    int prio;
+    ipmi::HandlerBase::ptr handler;
+    ipmid_callback_t legacyHandler;
+    ipmi_context_t context;
+};
+
+// same as ipmid: requests and responses never exceed this
+constexpr size_t maxIpmiBuffer = 256;
+
+std::shared_ptr<boost::asio::io_context> shimIo;
+std::shared_ptr<sdbusplus::asio::connection> shimConn;
+boost::container::flat_map<uint16_t, Registration> handlers;
+
+uint16_t handlerKey(uint8_t netfn, uint8_t cmd)
+{
+    return (static_cast<uint16_t>(netfn) << 8) | cmd;
+}
+
+// a later registration at the same or higher priority replaces the earlier
+// one, like it does in ipmid
+void addRegistration(uint8_t netfn, uint8_t cmd, Registration&& registration)
+{
+    auto it = handlers.find(handlerKey(netfn, cmd));
+    if (it != handlers.end() && it->second.prio > registration.prio)
+    {
+        return;
+    }
+    handlers[handlerKey(netfn, cmd)] = std::move(registration);
+}
+
+const Registration* findRegistration(uint8_t netfn, uint8_t cmd)
+{
+    auto it = handlers.find(handlerKey(netfn, cmd));
+    if (it == handlers.end())
+    {
+        it = handlers.find(handlerKey(netfn, IPMI_CMD_WILDCARD));
+    }
+    return it == handlers.end() ? nullptr : &it->second;
+}
+} // namespace
+
+// exported for the providers, in place of the ones in the ipmid executable
+sd_bus* ipmid_get_sd_bus_connection()
+{
+    return shimConn ? shimConn->get() : nullptr;
+}
+
+void ipmi_register_callback(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
+                            ipmi_context_t context, ipmid_callback_t handler,
+                            ipmi_cmd_privilege_t priv)
+{
+    addRegistration(netfn, cmd,
+                    {ipmi::prioOpenBmcBase, nullptr, handler, context});
+}
+
+namespace ipmi
+{
+std::shared_ptr<sdbusplus::asio::connection> getSdBus()
+{
+    return shimConn;
+}
+
+std::shared_ptr<boost::asio::io_context> getIo()
+{
+    return shimIo;
+}
+
+namespace impl
+{
+bool registerHandler(int prio, NetFn netFn, Cmd cmd, Privilege priv,
+                     ::ipmi::HandlerBase::ptr handler)
+{
+    addRegistration(netFn, cmd, {prio, handler, nullptr, nullptr});
+    return true;
+}
+} // namespace impl
+
+namespace test
+{
+void setConnection(std::shared_ptr<boost::asio::io_context> io,
+                   std::shared_ptr<sdbusplus::asio::connection> conn)
+{
+    shimIo = io;
+    shimConn = conn;
+}
+
+bool loadProvider(const std::string& path)
+{
+    // never closed, like in ipmid; handlers stay registered until exit
+    if (dlopen(path.c_str(), RTLD_NOW | RTLD_GLOBAL) == nullptr)
+    {
+        std::cerr << "Failed to load " << path << ": " << dlerror() << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool isRegistered(uint8_t netfn, uint8_t cmd)
+{
+    return findRegistration(netfn, cmd) != nullptr;
+}
+
+Response dispatch(uint8_t netfn, uint8_t cmd, const std::vector<uint8_t>& data)
+{
+    const Registration* registration = findRegistration(netfn, cmd);
+    if (registration == nullptr)
+    {
+        return {ccInvalidCommand, {}};
+    }
+
+    if (registration->handler)
+    {
+        auto ctx =
+            std::make_shared<Context>(netfn, cmd, 0, 0, Privilege::Admin);
+        auto request = std::make_shared<message::Request>(
+            ctx, std::vector<uint8_t>(data));
+        message::Response::ptr response =
+            registration->handler->call(request);
+        return {response->cc, response->payload.raw};
+    }
+
+    // legacy handlers cast the buffers to request/response structures, so
+    // both are full sized like ipmid's
+    std::array<uint8_t, maxIpmiBuffer> request{};
+    std::array<uint8_t, maxIpmiBuffer> response{};
+    size_t length = std::min(data.size(), request.size());
+    std::copy_n(data.begin(), length, request.begin());
+    ipmi_ret_t cc = registration->legacyHandler(
+        netfn, cmd, request.data(), response.data(), &length,
+        registration->context);
+    length = std::min(length, response.size());
+    return {cc, std::vector<uint8_t>(response.begin(),
+                                     response.begin() + length)};
+}
+} // namespace test
+} // namespace ipmi
@@ -0,0 +1,54 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <boost/asio/io_context.hpp>
+#include <cstdint>
+#include <memory>
+#include <sdbusplus/asio/connection.hpp>
+#include <string>
+#include <vector>
+
+// Stands in for the ipmid executable: provides the symbols providers expect
+// ipmid to export (bus/io accessors and both registration APIs) and
+// dispatches requests to whatever the loaded providers registered. The
+// executable linking this must export its symbols (ENABLE_EXPORTS) so the
+// providers bind to them when they are dlopen()ed.
+namespace ipmi
+{
+namespace test
+{
+struct Response
+{
+    uint8_t cc;
+    std::vector<uint8_t> data;
+};
+
+// must be called before any provider is loaded, their static initializers
+// already use the bus
+void setConnection(std::shared_ptr<boost::asio::io_context> io,
+                   std::shared_ptr<sdbusplus::asio::connection> conn);
+
+// dlopen()s a provider library, running its registration constructors
+bool loadProvider(const std::string& path);
+
+bool isRegistered(uint8_t netfn, uint8_t cmd);
+
+// runs the registered handler like ipmid would, at admin privilege on the
+// system interface
+Response dispatch(uint8_t netfn, uint8_t cmd, const std::vector<uint8_t>& data);
+} // namespace test
+} // namespace ipmi
@@ -0,0 +1,443 @@
+/*
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+// Replays host IPMI workloads against the real providers, loaded through the
+// ipmid registration API, on a generated fake platform. Reports throughput,
+// per command latency percentiles, D-Bus calls made and process memory.
+//
+//   ipmiReplay [--workload sdr-list|sel-list|sensor-poll|bios-post|
+//               bios-post-bundle|all|FILE]
+//              [--iterations N] [--sensors N] [--frus N] [--providers DIR]
+//              [--json]
+//
+// A recorded workload FILE has one request per line as hex bytes,
+// "netfn cmd data...", with '#' starting a comment.
+
+#include "dbusfixture.hpp"
+#include "ipmidshim.hpp"
+
+#include <algorithm>
+#include <boost/container/flat_map.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef IPMI_PROVIDER_DIR
+#define IPMI_PROVIDER_DIR "."
+#endif
+
+namespace
+{
+constexpr uint8_t netfnSensor = 0x04;
+constexpr uint8_t netfnStorage = 0x0a;
+constexpr uint8_t netfnIntelOem = 0x30;
+
+constexpr uint8_t cmdPlatformEvent = 0x02;
+constexpr uint8_t cmdGetSensorThresholds = 0x27;
+constexpr uint8_t cmdGetSensorReading = 0x2d;
+constexpr uint8_t cmdGetSdrRepositoryInfo = 0x20;
+constexpr uint8_t cmdReserveSdr = 0x22;
+constexpr uint8_t cmdGetSdr = 0x23;
+constexpr uint8_t cmdGetSelInfo = 0x40;
+constexpr uint8_t cmdGetSelEntry = 0x43;
+constexpr uint8_t cmdAddSel = 0x44;
+constexpr uint8_t cmdSetBiosId = 0x26;
+constexpr uint8_t cmdSetSystemGuid = 0x41;
+constexpr uint8_t cmdGetPowerRestoreDelay = 0x55;
+constexpr uint8_t cmdGetShutdownPolicy = 0x62;
+constexpr uint8_t cmdGetFanConfig = 0x8a;
+constexpr uint8_t cmdGetProcessorErrConfig = 0x9a;
+constexpr uint8_t cmdGetPostSettings = 0xe8;
+
+constexpr uint16_t lastRecord = 0xFFFF;
+constexpr size_t maxSelWalk = 1024;
+constexpr size_t maxSensorNumber = 254;
+constexpr uint8_t sdrTypeFull = 0x01;
+
+const char* providers[] = {"libzintelsensorcmds.so", "libzintelstoragecmds.so",
+                           "libzinteloemcmds.so"};
+
+struct CommandStats
+{
+    std::vector<double> latencyUs;
+    size_t errors = 0;
+    size_t dbusCalls = 0;
+};
+
+class Replay
+{
+  public:
+    Replay(boost::asio::io_context& io, ipmi::test::FakeServices& fakes) :
+        io(io), fakes(fakes)
+    {
+    }
+
+    ipmi::test::Response send(uint8_t netfn, uint8_t cmd,
+                              const std::vector<uint8_t>& data)
+    {
+        size_t callsBefore = fakes.callCount();
+        auto start = std::chrono::steady_clock::now();
+        ipmi::test::Response rsp = ipmi::test::dispatch(netfn, cmd, data);
+        auto end = std::chrono::steady_clock::now();
+
+        // let matches and timers the handler set up run, like ipmid's loop
+        // would between requests
+        io.poll();
+
+        CommandStats& entry =
+            stats[(static_cast<uint16_t>(netfn) << 8) | cmd];
+        entry.latencyUs.push_back(
+            std::chrono::duration<double, std::micro>(end - start).count());
+        entry.dbusCalls += fakes.callCount() - callsBefore;
+        if (rsp.cc != 0)
+        {
+            entry.errors++;
+        }
+        requests++;
+        elapsed += end - start;
+        return rsp;
+    }
+
+    void sdrList()
+    {
+        send(netfnStorage, cmdGetSdrRepositoryInfo, {});
+        ipmi::test::Response reserve = send(netfnStorage, cmdReserveSdr, {});
+        if (reserve.cc != 0 || reserve.data.size() < 2)
+        {
+            return;
+        }
+
+        uint16_t recordId = 0;
+        while (recordId != lastRecord)
+        {
+            ipmi::test::Response rsp = send(
+                netfnStorage, cmdGetSdr,
+                {reserve.data[0], reserve.data[1],
+                 static_cast<uint8_t>(recordId & 0xFF),
+                 static_cast<uint8_t>(recordId >> 8), 0, 0xFF});
+            // next record id, then the record header and key
+            if (rsp.cc != 0 || rsp.data.size() < 2 + 8)
+            {
+                return;
+            }
+            if (rsp.data[2 + 3] == sdrTypeFull)
+            {
+                send(netfnSensor, cmdGetSensorReading, {rsp.data[2 + 7]});
+            }
+            uint16_t next = rsp.data[0] | (rsp.data[1] << 8);
+            if (next == recordId)
+            {
+                return;
+            }
+            recordId = next;
+        }
+    }
+
+    void selList()
+    {
+        send(netfnStorage, cmdGetSelInfo, {});
+        uint16_t recordId = 0;
+        for (size_t walked = 0; walked < maxSelWalk && recordId != lastRecord;
+             walked++)
+        {
+            ipmi::test::Response rsp = send(
+                netfnStorage, cmdGetSelEntry,
+                {0, 0, static_cast<uint8_t>(recordId & 0xFF),
+                 static_cast<uint8_t>(recordId >> 8), 0, 0xFF});
+            if (rsp.cc != 0 || rsp.data.size() < 2)
+            {
+                return;
+            }
+            recordId = rsp.data[0] | (rsp.data[1] << 8);
+        }
+    }
+
+    void sensorPoll(size_t sensorCount)
+    {
+        size_t last = std::min(sensorCount, maxSensorNumber);
+        for (size_t sensor = 1; sensor <= last; sensor++)
+        {
+            uint8_t number = static_cast<uint8_t>(sensor);
+            send(netfnSensor, cmdGetSensorReading, {number});
+            send(netfnSensor, cmdGetSensorThresholds, {number});
+        }
+    }
+
+    // what BIOS sends over KCS while booting, with the settings reads
+    // either one by one or bundled into Get POST Settings
+    void biosPost(bool bundled = false)
+    {
+        std::vector<uint8_t> guid(16);
+        for (size_t i = 0; i < guid.size(); i++)
+        {
+            guid[i] = static_cast<uint8_t>(i * 17);
+        }
+        send(netfnIntelOem, cmdSetSystemGuid, guid);
+
+        std::string biosId = "SE5C620.86B.00.01.0016.020120190930";
+        std::vector<uint8_t> setBiosId{static_cast<uint8_t>(biosId.size())};
+        setBiosId.insert(setBiosId.end(), biosId.begin(), biosId.end());
+        send(netfnIntelOem, cmdSetBiosId, setBiosId);
+
+        if (bundled)
+        {
+            send(netfnIntelOem, cmdGetPostSettings, {});
+        }
+        else
+        {
+            send(netfnIntelOem, cmdGetPowerRestoreDelay, {});
+            send(netfnIntelOem, cmdGetProcessorErrConfig, {});
+            send(netfnIntelOem, cmdGetShutdownPolicy, {});
+            send(netfnIntelOem, cmdGetFanConfig, {});
+        }
+
+        // system event record from the BIOS generator id (0x0001)
+        send(netfnStorage, cmdAddSel,
+             {0, 0, 0x02, 0, 0, 0, 0, 0x01, 0, 0x04, 0x0f, 0x85, 0x6f, 0x02,
+              0xff, 0xff});
+        send(netfnSensor, cmdPlatformEvent,
+             {0x01, 0x04, 0x0f, 0x85, 0x6f, 0x02, 0xff, 0xff});
+    }
+
+    bool recorded(const std::string& fileName)
+    {
+        std::ifstream file(fileName);
+        if (!file.good())
+        {
+            std::cerr << "Can't open workload " << fileName << "\n";
+            return false;
+        }
+
+        std::string line;
+        while (std::getline(file, line))
+        {
+            line = line.substr(0, line.find('#'));
+            std::istringstream bytes(line);
+            std::vector<uint8_t> request;
+            unsigned int byte = 0;
+            while (bytes >> std::hex >> byte)
+            {
+                request.push_back(static_cast<uint8_t>(byte));
+            }
+            if (request.size() < 2)
+            {
+                continue;
+            }
+            send(request[0], request[1],
+                 std::vector<uint8_t>(request.begin() + 2, request.end()));
+        }
+        return true;
+    }
+
+    void report(bool json) const;
+
+  private:
+    boost::asio::io_context& io;
+    ipmi::test::FakeServices& fakes;
+    boost::container::flat_map<uint16_t, CommandStats> stats;
+    size_t requests = 0;
+    std::chrono::steady_clock::duration elapsed{0};
+};
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// VmRSS/VmHWM from /proc, in kB
+size_t readStatusKb(const std::string& field)
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, field.size(), field) == 0 &&
+            line.size() > field.size() && line[field.size()] == ':')
+        {
+            return std::stoul(line.substr(field.size() + 1));
+        }
+    }
+    return 0;
+}
+
+void Replay::report(bool json) const
+{
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    double throughput = seconds > 0 ? requests / seconds : 0;
+    size_t rss = readStatusKb("VmRSS");
+    size_t peakRss = readStatusKb("VmHWM");
+
+    if (json)
+    {
+        std::printf("{\n  \"requests\": %zu,\n  \"requests_per_second\": %.1f,"
+                    "\n  \"rss_kb\": %zu,\n  \"peak_rss_kb\": %zu,\n"
+                    "  \"commands\": [",
+                    requests, throughput, rss, peakRss);
+    }
+    else
+    {
+        std::printf("%zu requests, %.1f requests/s, RSS %zu kB (peak %zu kB)"
+                    "\n\n%-8s %8s %7s %10s %10s %10s %10s %10s\n",
+                    requests, throughput, rss, peakRss, "netfn:cmd", "count",
+                    "errors", "dbus/req", "p50 us", "p90 us", "p99 us",
+                    "max us");
+    }
+
+    const char* separator = "";
+    for (const auto& [key, entry] : stats)
+    {
+        std::vector<double> sorted = entry.latencyUs;
+        std::sort(sorted.begin(), sorted.end());
+        size_t count = sorted.size();
+        double callsPerRequest =
+            count ? static_cast<double>(entry.dbusCalls) / count : 0;
+        if (json)
+        {
+            std::printf("%s\n    {\"netfn\": %u, \"cmd\": %u, \"count\": %zu, "
+                        "\"errors\": %zu, \"dbus_calls\": %zu, "
+                        "\"p50_us\": %.1f, \"p90_us\": %.1f, "
+                        "\"p99_us\": %.1f, \"max_us\": %.1f}",
+                        separator, key >> 8, key & 0xFF, count, entry.errors,
+                        entry.dbusCalls, percentile(sorted, 0.5),
+                        percentile(sorted, 0.9), percentile(sorted, 0.99),
+                        count ? sorted.back() : 0);
+            separator = ",";
+        }
+        else
+        {
+            std::printf("%02x:%02x    %8zu %7zu %10.1f %10.1f %10.1f %10.1f "
+                        "%10.1f\n",
+                        key >> 8, key & 0xFF, count, entry.errors,
+                        callsPerRequest, percentile(sorted, 0.5),
+                        percentile(sorted, 0.9), percentile(sorted, 0.99),
+                        count ? sorted.back() : 0);
+        }
+    }
+    if (json)
+    {
+        std::printf("\n  ]\n}\n");
+    }
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::string workload = "all";
+    std::string providerDir = IPMI_PROVIDER_DIR;
+    size_t iterations = 10;
+    size_t sensorCount = 200;
+    size_t fruCount = 8;
+    bool json = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--json")
+        {
+            json = true;
+        }
+        else if (arg == "--workload" && hasValue)
+        {
+            workload = argv[++i];
+        }
+        else if (arg == "--iterations" && hasValue)
+        {
+            iterations = std::stoul(argv[++i]);
+        }
+        else if (arg == "--sensors" && hasValue)
+        {
+            sensorCount = std::stoul(argv[++i]);
+        }
+        else if (arg == "--frus" && hasValue)
+        {
+            fruCount = std::stoul(argv[++i]);
+        }
+        else if (arg == "--providers" && hasValue)
+        {
+            providerDir = argv[++i];
+        }
+        else
+        {
+            std::cerr << "usage: " << argv[0]
+                      << " [--workload sdr-list|sel-list|sensor-poll|"
+                         "bios-post|bios-post-bundle|all|FILE] [--iterations"
+                         " N] [--sensors N] [--frus N] [--providers DIR]"
+                         " [--json]\n";
+            return 1;
+        }
+    }
+
+    ipmi::test::FakePlatform platform(sensorCount, fruCount);
+
+    auto io = std::make_shared<boost::asio::io_context>();
+    auto conn = std::make_shared<sdbusplus::asio::connection>(*io);
+    ipmi::test::setConnection(io, conn);
+    for (const char* provider : providers)
+    {
+        if (!ipmi::test::loadProvider(providerDir + "/" + provider))
+        {
+            return 1;
+        }
+    }
+    // startup matches and cache fills the providers kicked off
+    io->poll();
+
+    Replay replay(*io, platform.services());
+    for (size_t i = 0; i < iterations; i++)
+    {
+        if (workload == "sdr-list" || workload == "all")
+        {
+            replay.sdrList();
+        }
+        if (workload == "sel-list" || workload == "all")
+        {
+            replay.selList();
+        }
+        if (workload == "sensor-poll" || workload == "all")
+        {
+            replay.sensorPoll(platform.platform().sensors.size());
+        }
+        if (workload == "bios-post" || workload == "all")
+        {
+            replay.biosPost();
+        }
+        if (workload == "bios-post-bundle")
+        {
+            replay.biosPost(true);
+        }
+        if (workload != "sdr-list" && workload != "sel-list" &&
+            workload != "sensor-poll" && workload != "bios-post" &&
+            workload != "bios-post-bundle" && workload != "all" &&
+            !replay.recorded(workload))
+        {
+            return 1;
+        }
+    }
+
+    replay.report(json);
+    return 0;
+}
@@ -0,0 +1,37 @@
+#include <commandstats.hpp>
+
+#include "gtest/gtest.h"
+
+TEST(commandstats, BucketIndex)
+{
+    EXPECT_EQ(ipmi::stats::histogramBucket(0), 0);
+    EXPECT_EQ(ipmi::stats::histogramBucket(1), 1);
+    EXPECT_EQ(ipmi::stats::histogramBucket(2), 2);
+    EXPECT_EQ(ipmi::stats::histogramBucket(3), 2);
+    EXPECT_EQ(ipmi::stats::histogramBucket(1000), 10);
+    EXPECT_EQ(ipmi::stats::histogramBucket(~0ULL),
+              ipmi::stats::histogramBuckets - 1);
+}
+
+TEST(commandstats, Percentiles)
+{
+    ipmi::stats::CommandHistogram histogram;
+    EXPECT_EQ(histogram.percentile(50), 0);
+
+    for (int i = 0; i < 98; i++)
+    {
+        histogram.record(100, 0);
+    }
+    histogram.record(5000, 0);
+    histogram.record(70000, 0xFF);
+
+    EXPECT_EQ(histogram.count, 100);
+    EXPECT_EQ(histogram.errors, 1);
+    EXPECT_EQ(histogram.maxUs, 70000);
+    EXPECT_EQ(histogram.totalUs, 98 * 100 + 5000 + 70000);
+
+    // 100us lands in the [64, 128) bucket
+    EXPECT_EQ(histogram.percentile(50), 128);
+    EXPECT_EQ(histogram.percentile(99), 8192);
+    EXPECT_EQ(histogram.percentile(100), 131072);
+}
@@ -0,0 +1,222 @@
+#include "dbusfixture.hpp"
+
+#include <boost/container/flat_map.hpp>
+#include <dbuspipeline.hpp>
+#include <numeric>
+#include <optional>
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/message.hpp>
+#include <sensorobjects.hpp>
+#include <string>
+#include <variant>
+#include <vector>
+#include <writebehind.hpp>
+
+#include "gtest/gtest.h"
+
+using GetSubTreeType = std::vector<
+    std::pair<std::string,
+              std::vector<std::pair<std::string, std::vector<std::string>>>>>;
+using Value = std::variant<bool, uint8_t, uint16_t, uint32_t, double,
+                           std::string, std::vector<std::string>>;
+using ManagedObjects = std::vector<std::pair<
+    sdbusplus::message::object_path,
+    boost::container::flat_map<
+        std::string, boost::container::flat_map<std::string, Value>>>>;
+
+TEST(dbusfixture, GeneratorClampsAndIsDeterministic)
+{
+    auto small = ipmi::test::generatePlatform(1, 0);
+    EXPECT_EQ(small.sensors.size(), ipmi::test::minSensors);
+    EXPECT_EQ(small.frus.size(), ipmi::test::minFrus);
+
+    auto large = ipmi::test::generatePlatform(5000, 500);
+    EXPECT_EQ(large.sensors.size(), ipmi::test::maxSensors);
+    EXPECT_EQ(large.frus.size(), ipmi::test::maxFrus);
+
+    auto again = ipmi::test::generatePlatform(5000, 500);
+    ASSERT_EQ(again.sensors.size(), large.sensors.size());
+    for (size_t ii = 0; ii < large.sensors.size(); ii++)
+    {
+        EXPECT_EQ(again.sensors[ii].path, large.sensors[ii].path);
+    }
+
+    // the baseboard is always device 0
+    EXPECT_EQ(large.frus[0].bus, 0);
+    EXPECT_EQ(large.frus[0].address, 0);
+}
+
+TEST(dbusfixture, FruDataChecksums)
+{
+    std::vector<uint8_t> data = ipmi::test::makeFruData("Baseboard");
+    ASSERT_GE(data.size(), 16);
+    EXPECT_EQ(uint8_t(std::accumulate(data.begin(), data.begin() + 8, 0)), 0);
+
+    size_t boardOffset = data[3] * 8;
+    size_t boardLength = data[boardOffset + 1] * 8;
+    ASSERT_EQ(boardOffset + boardLength, data.size());
+    EXPECT_EQ(uint8_t(std::accumulate(data.begin() + boardOffset, data.end(),
+                                      0)),
+              0);
+}
+
+TEST(dbusfixture, ServesSensorsAndFrus)
+{
+    ipmi::test::FakePlatform fake(100, 4);
+    auto bus = sdbusplus::bus::new_system();
+
+    auto mapperCall = bus.new_method_call(
+        "xyz.openbmc_project.ObjectMapper",
+        "/xyz/openbmc_project/object_mapper",
+        "xyz.openbmc_project.ObjectMapper", "GetSubTree");
+    mapperCall.append("/xyz/openbmc_project/sensors", 2,
+                      std::vector<std::string>{
+                          "xyz.openbmc_project.Sensor.Value"});
+    GetSubTreeType subtree;
+    bus.call(mapperCall).read(subtree);
+    EXPECT_EQ(subtree.size(), 100);
+
+    auto managedCall = bus.new_method_call(
+        "xyz.openbmc_project.HwmonTempSensor", "/",
+        "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+    ManagedObjects objects;
+    bus.call(managedCall).read(objects);
+    EXPECT_EQ(objects.size(), 20);
+
+    auto fruCall = bus.new_method_call(
+        "xyz.openbmc_project.FruDevice", "/xyz/openbmc_project/FruDevice",
+        "xyz.openbmc_project.FruDeviceManager", "GetRawFru");
+    fruCall.append(uint8_t(0), uint8_t(0));
+    std::vector<uint8_t> data;
+    bus.call(fruCall).read(data);
+    EXPECT_EQ(data, fake.platform().frus[0].data);
+
+    EXPECT_GE(fake.services().callCount(), 3);
+}
+
+TEST(dbusfixture, DecodesOnlySensorInterfaces)
+{
+    ipmi::test::FakePlatform fake(100, 1);
+    auto bus = sdbusplus::bus::new_system();
+
+    auto managedCall = bus.new_method_call(
+        "xyz.openbmc_project.HwmonTempSensor", "/",
+        "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+    auto reply = bus.call(managedCall);
+    ipmi::arena::RefreshArena arena;
+    ipmi::arena::ObjectMap objects(arena.resource());
+    ASSERT_GE(ipmi::readSensorObjects(reply.get(), arena, objects), 0);
+    ASSERT_EQ(objects.size(), 20);
+
+    for (const auto& [path, sensorMap] : objects)
+    {
+        EXPECT_EQ(sensorMap.count(
+                      "xyz.openbmc_project.State.Decorator.OperationalStatus"),
+                  0);
+        auto value = sensorMap.find("xyz.openbmc_project.Sensor.Value");
+        ASSERT_NE(value, sensorMap.end());
+        EXPECT_TRUE(std::holds_alternative<double>(value->second.at("Value")));
+    }
+
+    // the arena keeps what it needed, the next decode stays off the heap
+    objects.clear();
+    arena.reset();
+    size_t capacity = arena.capacity();
+    reply = bus.call(managedCall);
+    ASSERT_GE(ipmi::readSensorObjects(reply.get(), arena, objects), 0);
+    objects.clear();
+    arena.reset();
+    EXPECT_EQ(arena.capacity(), capacity);
+}
+
+TEST(dbusfixture, RecordsSelEntries)
+{
+    ipmi::test::FakePlatform fake(10, 1);
+    auto bus = sdbusplus::bus::new_system();
+
+    auto selCall = bus.new_method_call(
+        "xyz.openbmc_project.Logging.IPMI", "/xyz/openbmc_project/Logging/IPMI",
+        "xyz.openbmc_project.Logging.IPMI", "IpmiSelAdd");
+    selCall.append(std::string("test"),
+                   std::string("/xyz/openbmc_project/sensors/voltage/Volt_1"),
+                   std::vector<uint8_t>{1, 2, 3}, true, uint16_t(0x20));
+    uint16_t recordId = 0;
+    bus.call(selCall).read(recordId);
+    EXPECT_EQ(recordId, 1);
+
+    auto entries = fake.services().selEntries();
+    ASSERT_EQ(entries.size(), 1);
+    EXPECT_EQ(entries[0].data, std::vector<uint8_t>({1, 2, 3}));
+    EXPECT_EQ(entries[0].generatorId, 0x20);
+}
+
+TEST(dbusfixture, PipelinesPropertyWrites)
+{
+    ipmi::test::FakePlatform fake(100, 1);
+    auto bus = sdbusplus::bus::new_system();
+
+    static constexpr const char* warning =
+        "xyz.openbmc_project.Sensor.Threshold.Warning";
+    std::vector<ipmi::pipeline::PropertyWrite> writes;
+    for (const auto& sensor : fake.platform().sensors)
+    {
+        if (sensor.warningHigh)
+        {
+            writes.push_back({sensor.service, sensor.path, warning,
+                              "WarningHigh",
+                              ipmi::Value(*sensor.warningHigh - 1)});
+        }
+    }
+    ASSERT_GT(writes.size(), 8);
+    writes.push_back({"xyz.openbmc_project.NoSuchService", writes[0].path,
+                      warning, "WarningHigh", ipmi::Value(1.0)});
+
+    std::vector<int> results = ipmi::pipeline::setProperties(bus, writes, 8);
+    ASSERT_EQ(results.size(), writes.size());
+    for (size_t ii = 0; ii + 1 < results.size(); ii++)
+    {
+        EXPECT_EQ(results[ii], 0);
+    }
+    EXPECT_LT(results.back(), 0);
+
+    auto get = bus.new_method_call(writes[0].service.c_str(),
+                                   writes[0].path.c_str(),
+                                   "org.freedesktop.DBus.Properties", "Get");
+    get.append(warning, "WarningHigh");
+    std::variant<double> value;
+    bus.call(get).read(value);
+    EXPECT_EQ(std::get<double>(value), std::get<double>(writes[0].value));
+}
+
+TEST(dbusfixture, AppliesQueuedWritesInOrder)
+{
+    ipmi::test::FakePlatform fake(20, 1);
+    auto bus = sdbusplus::bus::new_system();
+
+    static constexpr const char* path =
+        "/xyz/openbmc_project/control/power_restore_delay";
+    static constexpr const char* intf =
+        "xyz.openbmc_project.Control.Power.RestoreDelay";
+    static constexpr const char* prop = "PowerRestoreDelay";
+    ipmi::writebehind::queue(bus, path, intf, prop, uint16_t(10));
+    ipmi::writebehind::queue(bus, "/xyz/openbmc_project/control/none", intf,
+                             prop, uint16_t(20));
+    ipmi::writebehind::queue(bus, path, intf, prop, uint16_t(30));
+
+    // the newest queued value is read back before anything is written
+    std::optional<ipmi::Value> queued =
+        ipmi::writebehind::pending(path, intf, prop);
+    ASSERT_TRUE(queued);
+    EXPECT_EQ(std::get<uint16_t>(*queued), 30);
+
+    // the write that fails doesn't hold up the ones after it
+    ipmi::writebehind::flush();
+    EXPECT_FALSE(ipmi::writebehind::pending(path, intf, prop));
+
+    auto get = bus.new_method_call("xyz.openbmc_project.Settings", path,
+                                   "org.freedesktop.DBus.Properties", "Get");
+    get.append(intf, prop);
+    std::variant<uint16_t> value;
+    bus.call(get).read(value);
+    EXPECT_EQ(std::get<uint16_t>(value), 30);
+}
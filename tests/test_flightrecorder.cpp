@@ -0,0 +1,26 @@
+#include <flightrecorder.hpp>
+
+#include "gtest/gtest.h"
+
+TEST(flightrecorder, PartiallyFilled)
+{
+    ipmi::flight::Ring<int, 4> ring;
+    EXPECT_TRUE(ring.snapshot().empty());
+
+    ring.push(1);
+    ring.push(2);
+    EXPECT_EQ(ring.count(), 2);
+    EXPECT_EQ(ring.snapshot(), std::vector<int>({1, 2}));
+}
+
+TEST(flightrecorder, Wraps)
+{
+    ipmi::flight::Ring<int, 4> ring;
+    for (int i = 1; i <= 10; i++)
+    {
+        ring.push(i);
+    }
+    EXPECT_EQ(ring.count(), 10);
+    // only the newest entries survive, oldest first
+    EXPECT_EQ(ring.snapshot(), std::vector<int>({7, 8, 9, 10}));
+}
@@ -0,0 +1,136 @@
+#include <cstdint>
+#include <fruutils.hpp>
+#include <numeric>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using ipmi::storage::checkFruChecksums;
+
+namespace
+{
+uint8_t zeroChecksum(std::vector<uint8_t>::const_iterator begin,
+                     std::vector<uint8_t>::const_iterator end)
+{
+    return static_cast<uint8_t>(-std::accumulate(begin, end, 0));
+}
+
+// common header, an eight byte board area at offset 1 and a multirecord area
+// at offset 2 holding one record per entry of recordLengths, the last flagged
+// end of list
+std::vector<uint8_t> makeFru(const std::vector<uint8_t>& recordLengths)
+{
+    std::vector<uint8_t> fru = {0x01, 0x00, 0x00, 0x01, 0x00,
+                                recordLengths.empty() ? uint8_t(0) : uint8_t(2),
+                                0x00};
+    fru.push_back(zeroChecksum(fru.begin(), fru.end()));
+
+    std::vector<uint8_t> board = {0x01, 0x01, 0x00, 0xc0, 0xc1, 0x00, 0x00};
+    board.push_back(zeroChecksum(board.begin(), board.end()));
+    fru.insert(fru.end(), board.begin(), board.end());
+
+    for (size_t ii = 0; ii < recordLengths.size(); ii++)
+    {
+        std::vector<uint8_t> data(recordLengths[ii]);
+        std::iota(data.begin(), data.end(), uint8_t(ii + 1));
+        bool last = ii + 1 == recordLengths.size();
+        std::vector<uint8_t> header = {
+            0xc0, static_cast<uint8_t>(0x02 | (last ? 0x80 : 0)),
+            recordLengths[ii], zeroChecksum(data.begin(), data.end())};
+        header.push_back(zeroChecksum(header.begin(), header.end()));
+        fru.insert(fru.end(), header.begin(), header.end());
+        fru.insert(fru.end(), data.begin(), data.end());
+    }
+    return fru;
+}
+
+constexpr size_t multiRecordStart = 16;
+} // namespace
+
+TEST(fruChecksums, ValidImage)
+{
+    EXPECT_TRUE(checkFruChecksums(makeFru({})));
+    EXPECT_TRUE(checkFruChecksums(makeFru({4, 0, 9})));
+}
+
+TEST(fruChecksums, TooShortForHeader)
+{
+    EXPECT_FALSE(checkFruChecksums({0x01, 0x00, 0x00}));
+}
+
+TEST(fruChecksums, BadCommonHeaderChecksum)
+{
+    auto fru = makeFru({});
+    fru[7]++;
+    EXPECT_FALSE(checkFruChecksums(fru));
+}
+
+TEST(fruChecksums, BadAreaChecksum)
+{
+    auto fru = makeFru({});
+    fru[8 + 5] ^= 0x01;
+    EXPECT_FALSE(checkFruChecksums(fru));
+}
+
+TEST(fruChecksums, AreaOffsetPastEnd)
+{
+    auto fru = makeFru({});
+    // product area at offset 3 (byte 24) in a 16 byte image
+    fru[4] = 0x03;
+    fru[7] -= 0x03;
+    EXPECT_FALSE(checkFruChecksums(fru));
+
+    // board area whose length runs past the end of the image
+    fru = makeFru({});
+    fru[8 + 1] = 0x02;
+    fru[15] -= 0x01;
+    EXPECT_FALSE(checkFruChecksums(fru));
+}
+
+TEST(fruChecksums, MultiRecordWithoutEndOfList)
+{
+    auto fru = makeFru({4});
+    fru[multiRecordStart + 1] &= 0x7f;
+    fru[multiRecordStart + 4] += 0x80;
+    EXPECT_FALSE(checkFruChecksums(fru));
+}
+
+TEST(fruChecksums, TruncatedMultiRecordHeader)
+{
+    auto fru = makeFru({4});
+    fru.resize(multiRecordStart + 3);
+    EXPECT_FALSE(checkFruChecksums(fru));
+
+    // record data cut short
+    fru = makeFru({4});
+    fru.pop_back();
+    EXPECT_FALSE(checkFruChecksums(fru));
+}
+
+TEST(fruChecksums, BadRecordChecksums)
+{
+    // header checksum
+    auto fru = makeFru({4, 4});
+    fru[multiRecordStart + 4]++;
+    EXPECT_FALSE(checkFruChecksums(fru));
+
+    // data checksum of the second record, header checksum kept valid
+    fru = makeFru({4, 4});
+    size_t second = multiRecordStart + 5 + 4;
+    fru[second + 3]++;
+    fru[second + 4]--;
+    EXPECT_FALSE(checkFruChecksums(fru));
+
+    // record data changed under an intact checksum
+    fru = makeFru({4, 4});
+    fru.back() ^= 0x10;
+    EXPECT_FALSE(checkFruChecksums(fru));
+}
+
+TEST(fruChecksums, UnknownRecordFormat)
+{
+    auto fru = makeFru({4});
+    fru[multiRecordStart + 1]++;
+    fru[multiRecordStart + 4]--;
+    EXPECT_FALSE(checkFruChecksums(fru));
+}
@@ -0,0 +1,520 @@
+// Handler tests for the OEM and sensor commands added on top of upstream:
+// the real providers are loaded through the ipmid shim and driven with raw
+// requests against a fake platform on a private bus, checking completion
+// codes, response bytes and what reached the fake services.
+
+#include "dbusfixture.hpp"
+#include "ipmidshim.hpp"
+
+#include <algorithm>
+#include <boost/asio/io_context.hpp>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ipmid/api.hpp>
+#include <memory>
+#include <oemcommands.hpp>
+#include <optional>
+#include <sdbusplus/asio/connection.hpp>
+#include <sdbusplus/bus.hpp>
+#include <sensorutils.hpp>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#ifndef IPMI_PROVIDER_DIR
+#define IPMI_PROVIDER_DIR "."
+#endif
+
+namespace
+{
+constexpr uint8_t netfnSensor = 0x04;
+constexpr uint8_t netfnStorage = 0x0a;
+constexpr uint8_t netfnIntelOem = 0x30;
+
+constexpr uint8_t cmdSetSensorEventEnable = 0x28;
+constexpr uint8_t cmdGetSensorEventEnable = 0x29;
+constexpr uint8_t cmdReadFruData = 0x11;
+constexpr uint8_t cmdWriteFruData = 0x12;
+constexpr uint8_t cmdSetSensorThresholdsBulk = 0xe2;
+constexpr uint8_t cmdBeginFruWrite = 0xe3;
+constexpr uint8_t cmdCommitFruWrite = 0xe4;
+constexpr uint8_t cmdAbortFruWrite = 0xe5;
+constexpr uint8_t cmdGetSensorByName = 0xe7;
+constexpr uint8_t cmdGetPostSettings = 0xe8;
+
+constexpr uint8_t ccSuccess = 0x00;
+constexpr uint8_t ccSensorInvalid = 0xcb;
+constexpr uint8_t ccParmOutOfRange = 0xc9;
+constexpr uint8_t ccReqDataLenInvalid = 0xc7;
+constexpr uint8_t ccInvalidFieldRequest = 0xcc;
+constexpr uint8_t ccCommandNotAvailable = 0xd5;
+
+// Set/Get Sensor Event Enable byte 2 and the threshold event mask bits
+constexpr uint8_t eventMessagesEnable = 1 << 7;
+constexpr uint8_t sensorScanningEnable = 1 << 6;
+constexpr uint8_t enableSelected = 1 << 4;
+constexpr uint8_t disableSelected = 2 << 4;
+constexpr uint8_t upperNonCriticalGoingHigh = 1 << 7;
+
+// Set Sensor Thresholds request, the bulk command takes a list of these
+constexpr size_t thresholdReqSize = 8;
+constexpr uint8_t setUpperCritical = 0x10;
+
+constexpr uint8_t lookupName = 0;
+constexpr uint8_t lookupPath = 1;
+constexpr uint8_t lookupNumber = 2;
+
+// more sensors than there are sensor numbers
+constexpr size_t sensorCount = 300;
+constexpr size_t fruCount = 1;
+constexpr uint8_t baseboard = 0;
+
+const char* providers[] = {"libzintelsensorcmds.so", "libzintelstoragecmds.so",
+                           "libzinteloemcmds.so"};
+
+using Value = std::variant<bool, uint8_t, uint16_t, uint32_t, double,
+                           std::string, std::vector<std::string>>;
+} // namespace
+
+class HandlerTest : public ::testing::Test
+{
+  protected:
+    // providers can only be loaded once per process, so the platform and
+    // the ipmid side of the bus are shared by all tests
+    static void SetUpTestCase()
+    {
+        platform = std::make_unique<ipmi::test::FakePlatform>(sensorCount,
+                                                             fruCount);
+        io = std::make_shared<boost::asio::io_context>();
+        conn = std::make_shared<sdbusplus::asio::connection>(*io);
+        ipmi::test::setConnection(io, conn);
+        for (const char* provider : providers)
+        {
+            ASSERT_TRUE(ipmi::test::loadProvider(
+                std::string(IPMI_PROVIDER_DIR) + "/" + provider));
+        }
+        // startup matches and cache fills the providers kicked off
+        io->poll();
+    }
+
+    static void TearDownTestCase()
+    {
+        platform.reset();
+    }
+
+    static ipmi::test::Response dispatch(uint8_t netfn, uint8_t cmd,
+                                         const std::vector<uint8_t>& data)
+    {
+        ipmi::test::Response response = ipmi::test::dispatch(netfn, cmd, data);
+        io->poll();
+        return response;
+    }
+
+    // sensor number of a platform sensor, 0xFF if it has none
+    static uint8_t sensorNumber(const std::string& path)
+    {
+        std::vector<uint8_t> request{lookupPath};
+        request.insert(request.end(), path.begin(), path.end());
+        ipmi::test::Response response =
+            dispatch(netfnIntelOem, cmdGetSensorByName, request);
+        if (response.cc != ccSuccess || response.data.empty())
+        {
+            return 0xFF;
+        }
+        return response.data[0];
+    }
+
+    static std::vector<uint8_t> getRawFru()
+    {
+        auto bus = sdbusplus::bus::new_system();
+        auto call = bus.new_method_call(
+            "xyz.openbmc_project.FruDevice", "/xyz/openbmc_project/FruDevice",
+            "xyz.openbmc_project.FruDeviceManager", "GetRawFru");
+        call.append(uint8_t(0), uint8_t(0));
+        std::vector<uint8_t> data;
+        bus.call(call).read(data);
+        return data;
+    }
+
+    static Value getProperty(const std::string& service,
+                             const std::string& path,
+                             const std::string& interface,
+                             const std::string& property)
+    {
+        auto bus = sdbusplus::bus::new_system();
+        auto call = bus.new_method_call(service.c_str(), path.c_str(),
+                                        "org.freedesktop.DBus.Properties",
+                                        "Get");
+        call.append(interface, property);
+        Value value;
+        bus.call(call).read(value);
+        return value;
+    }
+
+    static void setProperty(const std::string& service,
+                            const std::string& path,
+                            const std::string& interface,
+                            const std::string& property, const Value& value)
+    {
+        auto bus = sdbusplus::bus::new_system();
+        auto call = bus.new_method_call(service.c_str(), path.c_str(),
+                                        "org.freedesktop.DBus.Properties",
+                                        "Set");
+        call.append(interface, property, value);
+        bus.call(call);
+    }
+
+    // a platform sensor with a sensor number and all four thresholds
+    static const ipmi::test::FakeSensor& sensorWithThresholds(uint8_t& number)
+    {
+        for (const ipmi::test::FakeSensor& sensor :
+             platform->platform().sensors)
+        {
+            if (sensor.warningLow && sensor.warningHigh &&
+                sensor.criticalLow && sensor.criticalHigh)
+            {
+                number = sensorNumber(sensor.path);
+                if (number != 0xFF)
+                {
+                    return sensor;
+                }
+            }
+        }
+        throw std::runtime_error("no sensor with thresholds");
+    }
+
+    static std::unique_ptr<ipmi::test::FakePlatform> platform;
+    static std::shared_ptr<boost::asio::io_context> io;
+    static std::shared_ptr<sdbusplus::asio::connection> conn;
+};
+
+std::unique_ptr<ipmi::test::FakePlatform> HandlerTest::platform;
+std::shared_ptr<boost::asio::io_context> HandlerTest::io;
+std::shared_ptr<sdbusplus::asio::connection> HandlerTest::conn;
+
+TEST_F(HandlerTest, GetSensorByName)
+{
+    const std::string& path = platform->platform().sensors[0].path;
+    uint8_t number = sensorNumber(path);
+    ASSERT_NE(number, 0xFF);
+
+    // the label, ignoring case and '_' versus ' '
+    std::string label = path.substr(path.rfind('/') + 1);
+    std::string name = label;
+    for (char& c : name)
+    {
+        c = c == '_' ? ' ' : std::tolower(static_cast<unsigned char>(c));
+    }
+    std::vector<uint8_t> request{lookupName};
+    request.insert(request.end(), name.begin(), name.end());
+    ipmi::test::Response response =
+        dispatch(netfnIntelOem, cmdGetSensorByName, request);
+    ASSERT_EQ(response.cc, ccSuccess);
+    ASSERT_GE(response.data.size(), 3);
+    EXPECT_EQ(response.data[0], number);
+    // the record id is the sensor number
+    EXPECT_EQ(response.data[1], number);
+    EXPECT_EQ(response.data[2], 0);
+
+    // and back from the number to the SDR name
+    response =
+        dispatch(netfnIntelOem, cmdGetSensorByName, {lookupNumber, number});
+    ASSERT_EQ(response.cc, ccSuccess);
+    std::string sdrName = label;
+    std::replace(sdrName.begin(), sdrName.end(), '_', ' ');
+    EXPECT_EQ(std::string(response.data.begin() + 3, response.data.end()),
+              sdrName);
+
+    EXPECT_EQ(dispatch(netfnIntelOem, cmdGetSensorByName,
+                       {lookupName, 'n', 'o', 'n', 'e'})
+                  .cc,
+              ccSensorInvalid);
+    EXPECT_EQ(dispatch(netfnIntelOem, cmdGetSensorByName, {lookupName}).cc,
+              ccReqDataLenInvalid);
+    EXPECT_EQ(dispatch(netfnIntelOem, cmdGetSensorByName, {3, 0}).cc,
+              ccInvalidFieldRequest);
+}
+
+TEST_F(HandlerTest, GetSensorByNamePastLastSensorNumber)
+{
+    // 0xFF is reserved, sensors from there on have no number
+    EXPECT_EQ(
+        dispatch(netfnIntelOem, cmdGetSensorByName, {lookupNumber, 0xFF}).cc,
+        ccParmOutOfRange);
+
+    size_t numbered = 0;
+    size_t outOfRange = 0;
+    for (const ipmi::test::FakeSensor& sensor : platform->platform().sensors)
+    {
+        std::vector<uint8_t> request{lookupPath};
+        request.insert(request.end(), sensor.path.begin(), sensor.path.end());
+        uint8_t cc = dispatch(netfnIntelOem, cmdGetSensorByName, request).cc;
+        numbered += cc == ccSuccess;
+        outOfRange += cc == ccParmOutOfRange;
+    }
+    EXPECT_EQ(numbered, 0xFF);
+    EXPECT_EQ(outOfRange, sensorCount - 0xFF);
+}
+
+TEST_F(HandlerTest, SetSensorEventEnable)
+{
+    constexpr uint8_t events = eventMessagesEnable;
+    constexpr uint8_t scanning = sensorScanningEnable;
+
+    uint8_t number = 0xFF;
+    sensorWithThresholds(number);
+
+    ipmi::test::Response before =
+        dispatch(netfnSensor, cmdGetSensorEventEnable, {number});
+    ASSERT_EQ(before.cc, ccSuccess);
+    ASSERT_EQ(before.data.size(), 5);
+    EXPECT_EQ(before.data[0], events | scanning);
+    EXPECT_TRUE(before.data[1] & upperNonCriticalGoingHigh);
+
+    // reserved bits [3:0] are ignored
+    EXPECT_EQ(dispatch(netfnSensor, cmdSetSensorEventEnable,
+                       {number,
+                        static_cast<uint8_t>(events | scanning |
+                                             disableSelected | 0x0F),
+                        upperNonCriticalGoingHigh, 0, 0, 0})
+                  .cc,
+              ccSuccess);
+    ipmi::test::Response after =
+        dispatch(netfnSensor, cmdGetSensorEventEnable, {number});
+    ASSERT_EQ(after.cc, ccSuccess);
+    ASSERT_EQ(after.data.size(), 5);
+    EXPECT_EQ(after.data[1], before.data[1] & ~upperNonCriticalGoingHigh);
+    EXPECT_EQ(after.data[2], before.data[2]);
+    EXPECT_EQ(after.data[3], before.data[3]);
+    EXPECT_EQ(after.data[4], before.data[4]);
+
+    // scanning off, masks left alone
+    EXPECT_EQ(dispatch(netfnSensor, cmdSetSensorEventEnable, {number, events})
+                  .cc,
+              ccSuccess);
+    after = dispatch(netfnSensor, cmdGetSensorEventEnable, {number});
+    ASSERT_EQ(after.cc, ccSuccess);
+    EXPECT_EQ(after.data[0], events);
+    EXPECT_FALSE(after.data[1] & upperNonCriticalGoingHigh);
+
+    // back to the defaults
+    EXPECT_EQ(dispatch(netfnSensor, cmdSetSensorEventEnable,
+                       {number,
+                        static_cast<uint8_t>(events | scanning |
+                                             enableSelected),
+                        upperNonCriticalGoingHigh, 0, 0, 0})
+                  .cc,
+              ccSuccess);
+    after = dispatch(netfnSensor, cmdGetSensorEventEnable, {number});
+    EXPECT_EQ(after.data, before.data);
+
+    // selection 3 is reserved
+    EXPECT_EQ(dispatch(netfnSensor, cmdSetSensorEventEnable,
+                       {number, static_cast<uint8_t>(events | 3 << 4)})
+                  .cc,
+              ccInvalidFieldRequest);
+}
+
+TEST_F(HandlerTest, SetSensorThresholdsBulk)
+{
+    constexpr const char* criticalIntf =
+        "xyz.openbmc_project.Sensor.Threshold.Critical";
+
+    uint8_t number = 0xFF;
+    const ipmi::test::FakeSensor& sensor = sensorWithThresholds(number);
+
+    int16_t mValue = 0;
+    int8_t rExp = 0;
+    int16_t bValue = 0;
+    int8_t bExp = 0;
+    bool bSigned = false;
+    ASSERT_TRUE(ipmi::getSensorAttributes(sensor.maxValue, sensor.minValue,
+                                          mValue, rExp, bValue, bExp,
+                                          bSigned));
+    // halfway between upper critical and the top of the range
+    std::optional<uint8_t> raw = ipmi::scaleIPMIValueFromDouble(
+        (*sensor.criticalHigh + sensor.maxValue) / 2, mValue, rExp, bValue,
+        bExp, bSigned);
+    ASSERT_TRUE(raw);
+
+    // sensor number, mask, lower nc/c/nr, upper nc/c/nr
+    std::vector<uint8_t> request{number, setUpperCritical, 0, 0, 0, 0, *raw,
+                                 0};
+    // reserved mask bits
+    std::vector<uint8_t> invalid{number, 0xC0, 0, 0, 0, 0, 0, 0};
+    request.insert(request.end(), invalid.begin(), invalid.end());
+    ASSERT_EQ(request.size(), 2 * thresholdReqSize);
+
+    ipmi::test::Response response =
+        dispatch(netfnIntelOem, cmdSetSensorThresholdsBulk, request);
+    ASSERT_EQ(response.cc, ccSuccess);
+    EXPECT_EQ(response.data,
+              std::vector<uint8_t>({ccSuccess, ccInvalidFieldRequest}));
+
+    Value written = getProperty(sensor.service, sensor.path, criticalIntf,
+                                "CriticalHigh");
+    ASSERT_TRUE(std::holds_alternative<double>(written));
+    EXPECT_GT(std::get<double>(written), *sensor.criticalHigh);
+    std::optional<uint8_t> writtenRaw = ipmi::scaleIPMIValueFromDouble(
+        std::get<double>(written), mValue, rExp, bValue, bExp, bSigned);
+    ASSERT_TRUE(writtenRaw);
+    EXPECT_NEAR(*writtenRaw, *raw, 1);
+
+    // a partial entry fails the whole request
+    request.pop_back();
+    EXPECT_EQ(dispatch(netfnIntelOem, cmdSetSensorThresholdsBulk, request).cc,
+              ccReqDataLenInvalid);
+    EXPECT_EQ(dispatch(netfnIntelOem, cmdSetSensorThresholdsBulk, {}).cc,
+              ccReqDataLenInvalid);
+
+    setProperty(sensor.service, sensor.path, criticalIntf, "CriticalHigh",
+                *sensor.criticalHigh);
+}
+
+TEST_F(HandlerTest, FruWriteCommit)
+{
+    std::vector<uint8_t> original = getRawFru();
+    // same size as the baseboard's image, so the write needs one request
+    std::vector<uint8_t> renamed = ipmi::test::makeFruData("Mainboard");
+    ASSERT_EQ(renamed.size(), original.size());
+    ASSERT_LT(renamed.size(), 0xF0);
+
+    EXPECT_EQ(
+        dispatch(netfnIntelOem, cmdCommitFruWrite, {baseboard}).cc,
+        ccCommandNotAvailable);
+    EXPECT_EQ(dispatch(netfnIntelOem, cmdBeginFruWrite, {0xFF}).cc,
+              ccInvalidFieldRequest);
+    ASSERT_EQ(dispatch(netfnIntelOem, cmdBeginFruWrite, {baseboard}).cc,
+              ccSuccess);
+
+    std::vector<uint8_t> write{baseboard, 0, 0};
+    write.insert(write.end(), renamed.begin(), renamed.end());
+    ipmi::test::Response response =
+        dispatch(netfnStorage, cmdWriteFruData, write);
+    ASSERT_EQ(response.cc, ccSuccess);
+    EXPECT_EQ(response.data, std::vector<uint8_t>{uint8_t(renamed.size())});
+
+    // reads see the staged image, the device doesn't until commit
+    response = dispatch(netfnStorage, cmdReadFruData,
+                        {baseboard, 0, 0, uint8_t(renamed.size())});
+    ASSERT_EQ(response.cc, ccSuccess);
+    ASSERT_EQ(response.data.size(), renamed.size() + 1);
+    EXPECT_TRUE(std::equal(renamed.begin(), renamed.end(),
+                           response.data.begin() + 1));
+    EXPECT_EQ(getRawFru(), original);
+
+    ASSERT_EQ(dispatch(netfnIntelOem, cmdCommitFruWrite, {baseboard}).cc,
+              ccSuccess);
+    EXPECT_EQ(getRawFru(), renamed);
+    EXPECT_EQ(
+        dispatch(netfnIntelOem, cmdCommitFruWrite, {baseboard}).cc,
+        ccCommandNotAvailable);
+
+    // put the baseboard back for the other tests
+    ASSERT_EQ(dispatch(netfnIntelOem, cmdBeginFruWrite, {baseboard}).cc,
+              ccSuccess);
+    write.resize(3);
+    write.insert(write.end(), original.begin(), original.end());
+    ASSERT_EQ(dispatch(netfnStorage, cmdWriteFruData, write).cc, ccSuccess);
+    ASSERT_EQ(dispatch(netfnIntelOem, cmdCommitFruWrite, {baseboard}).cc,
+              ccSuccess);
+    EXPECT_EQ(getRawFru(), original);
+}
+
+TEST_F(HandlerTest, FruWriteBadChecksumAndAbort)
+{
+    std::vector<uint8_t> original = getRawFru();
+    ASSERT_EQ(dispatch(netfnIntelOem, cmdBeginFruWrite, {baseboard}).cc,
+              ccSuccess);
+
+    // one byte of the board area, its checksum left as it was
+    size_t boardOffset = original[3] * 8;
+    std::vector<uint8_t> write{baseboard, uint8_t(boardOffset + 8), 0,
+                               uint8_t(original[boardOffset + 8] ^ 0x01)};
+    ASSERT_EQ(dispatch(netfnStorage, cmdWriteFruData, write).cc, ccSuccess);
+
+    // rejected, and the transaction stays open to be fixed or aborted
+    EXPECT_EQ(dispatch(netfnIntelOem, cmdCommitFruWrite, {baseboard}).cc,
+              ccInvalidFieldRequest);
+    EXPECT_EQ(getRawFru(), original);
+    EXPECT_EQ(dispatch(netfnIntelOem, cmdAbortFruWrite, {baseboard}).cc,
+              ccSuccess);
+    EXPECT_EQ(getRawFru(), original);
+
+    EXPECT_EQ(dispatch(netfnIntelOem, cmdAbortFruWrite, {baseboard}).cc,
+              ccCommandNotAvailable);
+    EXPECT_EQ(
+        dispatch(netfnIntelOem, cmdCommitFruWrite, {baseboard}).cc,
+        ccCommandNotAvailable);
+
+    // without a transaction reads come from the device again
+    ipmi::test::Response response = dispatch(
+        netfnStorage, cmdReadFruData, {baseboard, 0, 0, uint8_t(16)});
+    ASSERT_EQ(response.cc, ccSuccess);
+    ASSERT_EQ(response.data.size(), 17);
+    EXPECT_TRUE(std::equal(original.begin(), original.begin() + 16,
+                           response.data.begin() + 1));
+}
+
+TEST_F(HandlerTest, GetPostSettings)
+{
+    constexpr const char* settingsService = "xyz.openbmc_project.Settings";
+    constexpr const char* restoreDelayPath =
+        "/xyz/openbmc_project/control/power_restore_delay";
+    constexpr const char* restoreDelayIntf =
+        "xyz.openbmc_project.Control.Power.RestoreDelay";
+
+    auto getRecord = [](PostSettingsRecord& record) {
+        ipmi::test::Response response =
+            dispatch(netfnIntelOem, cmdGetPostSettings, {});
+        ASSERT_EQ(response.cc, ccSuccess);
+        ASSERT_GE(response.data.size(), sizeof(record));
+        std::memcpy(&record, response.data.data(), sizeof(record));
+    };
+
+    PostSettingsRecord record;
+    getRecord(record);
+    if (HasFatalFailure())
+    {
+        return;
+    }
+    auto valid = [&record](PostSettingsValid bit) {
+        return (record.valid & static_cast<uint8_t>(bit)) != 0;
+    };
+    EXPECT_TRUE(valid(PostSettingsValid::powerRestoreDelay));
+    EXPECT_TRUE(valid(PostSettingsValid::shutdownPolicy));
+    EXPECT_TRUE(valid(PostSettingsValid::processorErrConfig));
+    EXPECT_TRUE(valid(PostSettingsValid::fanProfile));
+    EXPECT_TRUE(valid(PostSettingsValid::cfm));
+    // the fake processor error config has no CATERRStatus
+    EXPECT_FALSE(valid(PostSettingsValid::caterrStatus));
+    EXPECT_EQ(record.powerRestoreDelay, 0);
+    EXPECT_EQ(record.resetCfg, 0);
+    // thermal mode Performance
+    EXPECT_TRUE(record.fanProfileFlags & 1 << 2);
+    EXPECT_EQ(record.cfmLimit, 0);
+    EXPECT_EQ(record.cfmMaximum, 50);
+
+    // a change made behind ipmid's back shows up once its signal is in
+    setProperty(settingsService, restoreDelayPath, restoreDelayIntf,
+                "PowerRestoreDelay", uint16_t(30));
+    for (int ii = 0; ii < 100 && record.powerRestoreDelay != 30; ii++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        getRecord(record);
+        if (HasFatalFailure())
+        {
+            return;
+        }
+    }
+    EXPECT_EQ(record.powerRestoreDelay, 30);
+
+    setProperty(settingsService, restoreDelayPath, restoreDelayIntf,
+                "PowerRestoreDelay", uint16_t(0));
+}
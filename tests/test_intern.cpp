@@ -0,0 +1,42 @@
+#include <intern.hpp>
+#include <string>
+
+#include "gtest/gtest.h"
+
+TEST(intern, SameStringSameId)
+{
+    ipmi::intern::Table table;
+    ipmi::intern::Id temp =
+        table.intern("/xyz/openbmc_project/sensors/temperature/CPU1_Temp");
+    ipmi::intern::Id volt =
+        table.intern("/xyz/openbmc_project/sensors/voltage/P12V");
+    EXPECT_NE(temp, volt);
+
+    std::string again = "/xyz/openbmc_project/sensors/temperature/CPU1_Temp";
+    EXPECT_EQ(table.intern(again), temp);
+    EXPECT_EQ(table.find(again), temp);
+    EXPECT_EQ(table.str(volt), "/xyz/openbmc_project/sensors/voltage/P12V");
+    EXPECT_EQ(table.size(), 2);
+}
+
+TEST(intern, UnknownStringNotAdded)
+{
+    ipmi::intern::Table table;
+    EXPECT_EQ(table.find("xyz.openbmc_project.Sensor.Value"),
+              ipmi::intern::invalidId);
+    EXPECT_EQ(table.size(), 0);
+}
+
+TEST(intern, ViewsStayValid)
+{
+    ipmi::intern::Table table;
+    std::string_view first = table.view("xyz.openbmc_project.Sensor.Value");
+    for (int ii = 0; ii < 1000; ii++)
+    {
+        table.intern("/xyz/openbmc_project/sensors/fan_tach/Fan_" +
+                     std::to_string(ii));
+    }
+    EXPECT_EQ(table.view("xyz.openbmc_project.Sensor.Value").data(),
+              first.data());
+    EXPECT_EQ(first, "xyz.openbmc_project.Sensor.Value");
+}
@@ -0,0 +1,47 @@
+#include <chrono>
+#include <ratelog.hpp>
+#include <string>
+
+#include "gtest/gtest.h"
+
+using namespace std::chrono_literals;
+
+TEST(ratelog, BurstThenSuppressed)
+{
+    ipmi::ratelog::Site site("test", 3, 10s);
+    auto now = std::chrono::steady_clock::now();
+    for (int ii = 0; ii < 3; ii++)
+    {
+        EXPECT_TRUE(site.admit(now));
+    }
+    EXPECT_FALSE(site.admit(now));
+    EXPECT_FALSE(site.admit(now + 9s));
+    EXPECT_EQ(site.suppressed(), 2);
+}
+
+TEST(ratelog, SuppressedCountedOnNextRecord)
+{
+    ipmi::ratelog::Site site("test", 1, 10s);
+    auto now = std::chrono::steady_clock::now();
+    EXPECT_TRUE(site.admit(now));
+    EXPECT_EQ(site.takeSuppressed(), 0);
+    for (int ii = 0; ii < 5; ii++)
+    {
+        EXPECT_FALSE(site.admit(now + 1s));
+    }
+
+    // a new interval lets records through again
+    EXPECT_TRUE(site.admit(now + 10s));
+    EXPECT_EQ(site.takeSuppressed(), 5);
+    EXPECT_EQ(site.takeSuppressed(), 0);
+    EXPECT_EQ(site.suppressed(), 5);
+}
+
+TEST(ratelog, EntryFormatsOnDemand)
+{
+    std::string connection = "xyz.openbmc_project.HwmonTempSensor";
+    auto field = ipmi::ratelog::entry("CONNECTION=%s", connection.c_str());
+    EXPECT_EQ(field.str(), "CONNECTION=xyz.openbmc_project.HwmonTempSensor");
+    EXPECT_EQ(ipmi::ratelog::entry("ERRNO=%d", -5).str(), "ERRNO=-5");
+    EXPECT_EQ(ipmi::ratelog::entry("NO_ARGS").str(), "NO_ARGS");
+}
@@ -0,0 +1,116 @@
+#include <cstdint>
+#include <optional>
+#include <selutils.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace sel = intel_oem::ipmi::sel;
+
+namespace
+{
+// what the SEL decoding did before parseUnsigned replaced std::stoul
+std::optional<unsigned long> referenceStoul(const std::string& str, int base)
+{
+    try
+    {
+        return std::stoul(str, nullptr, base);
+    }
+    catch (const std::invalid_argument&)
+    {
+        return std::nullopt;
+    }
+    catch (const std::out_of_range&)
+    {
+        return std::nullopt;
+    }
+}
+
+std::optional<unsigned long> parse(const std::string& str, int base)
+{
+    unsigned long value = 0;
+    if (!sel::parseUnsigned(str, base, value))
+    {
+        return std::nullopt;
+    }
+    return value;
+}
+
+const std::vector<std::string> inputs = {
+    // plain numbers and leading whitespace
+    "0", "7", "42", "ff", "FF", " 12", "\t\n 34", "\v\f\r5", "   ",
+    // signs and prefixes
+    "+8", "-1", "-0", "+-1", "-+1", "- 1", "+", "-", "0x", "0X1f", "0xg",
+    "-0x10", "+0x10", "x10", "00x1",
+    // overflow
+    "4294967295", "4294967296", "18446744073709551615",
+    "18446744073709551616", "99999999999999999999999",
+    "-18446744073709551616", "0xffffffffffffffff", "0x10000000000000000",
+    // empty and trailing garbage
+    "", "12abc", "12 34", "1.5", "7-", "0x12zz", "zz", "\x80" "1"};
+} // namespace
+
+TEST(selutils, ParseUnsignedMatchesStoul)
+{
+    for (int base : {10, 16})
+    {
+        for (const std::string& input : inputs)
+        {
+            EXPECT_EQ(parse(input, base), referenceStoul(input, base))
+                << "input \"" << input << "\" base " << base;
+        }
+    }
+}
+
+TEST(selutils, FromHexStrMatchesStoul)
+{
+    const std::vector<std::string> hexStrings = {
+        "", "00", "0a1B", "ffFF", "abc", "a", "0x", "x0", "-1", "+1", " 1",
+        "1 ", "12345", "zz", "12zz34", "0x0x"};
+    for (const std::string& hexStr : hexStrings)
+    {
+        std::vector<uint8_t> expected;
+        int expectedRet = 0;
+        for (size_t ii = 0; ii < hexStr.size(); ii += 2)
+        {
+            auto value = referenceStoul(hexStr.substr(ii, 2), 16);
+            if (!value)
+            {
+                expectedRet = -1;
+                break;
+            }
+            expected.push_back(static_cast<uint8_t>(*value));
+        }
+
+        std::vector<uint8_t> data;
+        EXPECT_EQ(sel::fromHexStr(hexStr, data), expectedRet)
+            << "input \"" << hexStr << "\"";
+        EXPECT_EQ(data, expected) << "input \"" << hexStr << "\"";
+    }
+}
+
+TEST(selutils, ParseJournalIntMatchesStoul)
+{
+    for (int base : {10, 16})
+    {
+        for (const std::string& input : inputs)
+        {
+            auto expected = referenceStoul(input, base);
+            int contents = -2;
+            int ret = sel::parseJournalInt(input, base, contents);
+            if (expected)
+            {
+                EXPECT_EQ(ret, 0) << "input \"" << input << "\"";
+                EXPECT_EQ(contents, static_cast<int>(*expected))
+                    << "input \"" << input << "\"";
+            }
+            else
+            {
+                EXPECT_EQ(ret, -1) << "input \"" << input << "\"";
+                EXPECT_EQ(contents, -2) << "input \"" << input << "\"";
+            }
+        }
+    }
+}
@@ -1,5 +1,8 @@
 #include <cmath>
+#include <optional>
 #include <sensorutils.hpp>
+#include <string>
+#include <string_view>
 
 #include "gtest/gtest.h"
 
@@ -17,7 +20,7 @@ TEST(sensorutils, TranslateToIPMI)
     bool bSigned;
     bool result;
 
-    uint8_t scaledVal;
+    std::optional<uint8_t> scaledVal;
 
     result = ipmi::getSensorAttributes(maxValue, minValue, mValue, rExp, bValue,
                                        bExp, bSigned);
@@ -33,7 +36,8 @@ TEST(sensorutils, TranslateToIPMI)
     double expected = 0x50;
     scaledVal = ipmi::scaleIPMIValueFromDouble(0x50, mValue, rExp, bValue, bExp,
                                                bSigned);
-    EXPECT_NEAR(scaledVal, expected, expected * 0.01);
+    ASSERT_TRUE(scaledVal);
+    EXPECT_NEAR(*scaledVal, expected, expected * 0.01);
 
     // normal signed sensor
     maxValue = 127;
@@ -87,7 +91,8 @@ TEST(sensorutils, TranslateToIPMI)
                                                bSigned);
 
     expected = 12.2 / (mValue * std::pow(10, rExp));
-    EXPECT_NEAR(scaledVal, expected, expected * 0.01);
+    ASSERT_TRUE(scaledVal);
+    EXPECT_NEAR(*scaledVal, expected, expected * 0.01);
 
     // shifted fan example
     maxValue = 16000;
@@ -126,7 +131,8 @@ TEST(sensorutils, TranslateToIPMI)
         ipmi::scaleIPMIValueFromDouble(5, mValue, rExp, bValue, bExp, bSigned);
 
     expected = 5 / (mValue * std::pow(10, rExp));
-    EXPECT_NEAR(scaledVal, expected, expected * 0.01);
+    ASSERT_TRUE(scaledVal);
+    EXPECT_NEAR(*scaledVal, expected, expected * 0.01);
 
     // 0, 0 failure
     maxValue = 0;
@@ -142,3 +148,60 @@ TEST(sensorutils, TranslateToIPMI)
                                        bExp, bSigned);
     EXPECT_EQ(result, false);
 }
+
+TEST(sensorutils, ScaleOutOfRange)
+{
+    int16_t mValue = 0;
+    int8_t rExp = 0;
+    int16_t bValue = 0;
+    int8_t bExp = 0;
+    bool bSigned = false;
+
+    ASSERT_TRUE(ipmi::getSensorAttributes(0xFF, 0, mValue, rExp, bValue, bExp,
+                                          bSigned));
+    EXPECT_EQ(ipmi::scaleIPMIValueFromDouble(0xFF, mValue, rExp, bValue, bExp,
+                                             bSigned),
+              0xFF);
+    EXPECT_EQ(ipmi::scaleIPMIValueFromDouble(0x100, mValue, rExp, bValue,
+                                             bExp, bSigned),
+              std::nullopt);
+    EXPECT_EQ(ipmi::getScaledIPMIValue(0x50, 0, 0), std::nullopt);
+}
+
+TEST(sensorutils, PowerGatedLabels)
+{
+    auto gated = [](std::string_view label) {
+        return ipmi::isPowerGatedLabel(
+            "/xyz/openbmc_project/sensors/temperature/" + std::string(label));
+    };
+    for (std::string_view label :
+         {"CPU1_Temp", "DIMM_A1", "VR_CPU1_VCCIN", "PCH_Temp", "Die CPU2",
+          "P1V8_PCH", "CPU"})
+    {
+        EXPECT_TRUE(gated(label)) << label;
+    }
+
+    // the word only as part of another one, or not in upper case
+    for (std::string_view label :
+         {"CpuFan", "Cpu1_Temp", "cpu1_temp", "Dimm_A1", "Vref", "VRM_Temp",
+          "CPUA_Temp", "Fan_PCHX", "SubCPU1", "Exit_Air_Temp"})
+    {
+        EXPECT_FALSE(gated(label)) << label;
+    }
+
+    // only the label counts, not the directories above it
+    EXPECT_FALSE(ipmi::isPowerGatedLabel("/CPU1/sensors/Exit_Air_Temp"));
+}
+
+TEST(sensorutils, PowerGateCachedPerPath)
+{
+    ipmi::PowerGateCache cache;
+    EXPECT_TRUE(cache.isGated(1, "/xyz/openbmc_project/sensors/CPU1_Temp"));
+    EXPECT_FALSE(cache.isGated(2, "/xyz/openbmc_project/sensors/Inlet_Temp"));
+    EXPECT_EQ(cache.size(), 2);
+
+    // a repeated path id answers from the cache without looking at the label
+    EXPECT_TRUE(cache.isGated(1, "/xyz/openbmc_project/sensors/Inlet_Temp"));
+    EXPECT_FALSE(cache.isGated(2, "/xyz/openbmc_project/sensors/CPU1_Temp"));
+    EXPECT_EQ(cache.size(), 2);
+}